@@ -1,23 +1,84 @@
 #include "bitio.hpp"
-#include <stdexcept>
+#include <algorithm>
+#include <cstring>
 
 namespace glic {
 
-void BitWriter::writeBit(bool bit) {
-    if (bit) {
-        currentByte_ |= (1 << (7 - bitPos_));
+namespace {
+
+inline uint64_t fromBigEndian(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(v);
+#else
+    return v;
+#endif
+#else
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(&v);
+    uint64_t r = 0;
+    for (int i = 0; i < 8; i++) r = (r << 8) | b[i];
+    return r;
+#endif
+}
+
+inline int leadingZeros(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return v ? __builtin_clzll(v) : 64;
+#else
+    int n = 0;
+    while (n < 64 && !((v >> (63 - n)) & 1)) n++;
+    return n;
+#endif
+}
+
+} // anonymous namespace
+
+void BitWriter::flushWord() {
+    uint32_t word = static_cast<uint32_t>(acc_ >> (accBits_ - 32));
+    uint8_t bytes[4] = {
+        static_cast<uint8_t>(word >> 24), static_cast<uint8_t>(word >> 16),
+        static_cast<uint8_t>(word >> 8), static_cast<uint8_t>(word)
+    };
+    buffer_.insert(buffer_.end(), bytes, bytes + 4);
+    accBits_ -= 32;
+    if (out_ && buffer_.size() >= STREAM_CHUNK) {
+        drain();
     }
-    bitPos_++;
-    if (bitPos_ == 8) {
-        buffer_.push_back(currentByte_);
-        currentByte_ = 0;
-        bitPos_ = 0;
+}
+
+void BitWriter::drain() {
+    out_->write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void BitWriter::flushOutput() {
+    flushBytes();
+    if (out_ && !buffer_.empty()) {
+        drain();
+    }
+}
+
+void BitWriter::flushBytes() const {
+    while (accBits_ >= 8) {
+        buffer_.push_back(static_cast<uint8_t>(acc_ >> (accBits_ - 8)));
+        accBits_ -= 8;
+    }
+}
+
+void BitWriter::writeBit(bool bit) {
+    acc_ = (acc_ << 1) | (bit ? 1 : 0);
+    if (++accBits_ >= 32) {
+        flushWord();
     }
 }
 
 void BitWriter::writeBits(uint32_t value, int numBits) {
-    for (int i = numBits - 1; i >= 0; i--) {
-        writeBit((value >> i) & 1);
+    if (numBits <= 0) return;
+    // Bits above accBits_ are never read back, so the accumulator is not masked
+    acc_ = (acc_ << numBits) | (value & (~uint64_t(0) >> (64 - numBits)));
+    accBits_ += numBits;
+    if (accBits_ >= 32) {
+        flushWord();
     }
 }
 
@@ -34,52 +95,147 @@ void BitWriter::writeInt(int32_t value, bool isSigned, int numBits) {
 }
 
 void BitWriter::writeByte(uint8_t value) {
-    if (bitPos_ == 0) {
-        buffer_.push_back(value);
-    } else {
-        writeBits(value, 8);
-    }
+    writeBits(value, 8);
 }
 
 void BitWriter::writeBytes(const uint8_t* data, size_t size) {
+    if (accBits_ % 8 == 0) {
+        // Byte aligned: drain the accumulator and copy straight through
+        flushBytes();
+        size_t offset = buffer_.size();
+        buffer_.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(buffer_.data() + offset, data, size);
+        }
+        if (out_ && buffer_.size() >= STREAM_CHUNK) {
+            drain();
+        }
+        return;
+    }
     for (size_t i = 0; i < size; i++) {
-        writeByte(data[i]);
+        writeBits(data[i], 8);
     }
 }
 
 void BitWriter::align() {
-    if (bitPos_ != 0) {
-        buffer_.push_back(currentByte_);
-        currentByte_ = 0;
-        bitPos_ = 0;
-    }
+    int pad = (8 - accBits_ % 8) % 8;
+    acc_ <<= pad;
+    accBits_ += pad;
+    flushBytes();
 }
 
 void BitWriter::clear() {
     buffer_.clear();
-    bitPos_ = 0;
-    currentByte_ = 0;
+    acc_ = 0;
+    accBits_ = 0;
 }
 
-bool BitReader::readBit() {
-    if (bytePos_ >= size_) {
-        throw std::runtime_error("BitReader: End of data");
+void BitReader::refill() {
+    if (bytePos_ + 8 <= size_) {
+        // Load a whole word; bits past the whole bytes taken are the same
+        // stream bits the next refill ORs in, so they need no masking
+        uint64_t word = 0;
+        for (int i = 0; i < 8; i++) {
+            word = (word << 8) | data_[bytePos_ + i];
+        }
+        buf_ |= word >> bufBits_;
+        int taken = (63 - bufBits_) >> 3;
+        bytePos_ += taken;
+        bufBits_ += taken * 8;
+        return;
     }
-    bool bit = (data_[bytePos_] >> (7 - bitPos_)) & 1;
-    bitPos_++;
-    if (bitPos_ == 8) {
-        bytePos_++;
-        bitPos_ = 0;
+    while (bufBits_ <= 56 && bytePos_ < size_) {
+        buf_ |= static_cast<uint64_t>(data_[bytePos_++]) << (56 - bufBits_);
+        bufBits_ += 8;
     }
-    return bit;
+}
+
+bool BitReader::readBit() {
+    return readBits(1) != 0;
 }
 
 uint32_t BitReader::readBits(int numBits) {
-    uint32_t result = 0;
-    for (int i = 0; i < numBits; i++) {
-        result = (result << 1) | (readBit() ? 1 : 0);
+    if (numBits <= 0) return 0;
+    if (bufBits_ < numBits) {
+        refill();
+        if (bufBits_ < numBits) {
+            // Out of data: the missing low bits read as zero
+            uint32_t value = peek(numBits);
+            overrun_ = true;
+            buf_ = 0;
+            bufBits_ = 0;
+            return value;
+        }
+    }
+    uint32_t value = peek(numBits);
+    consume(numBits);
+    return value;
+}
+
+void BitReader::seek(size_t bitPos) {
+    buf_ = 0;
+    bufBits_ = 0;
+    bytePos_ = std::min(bitPos / 8, size_);
+    int skip = static_cast<int>(bitPos % 8);
+    if (skip > 0) {
+        refill();
+        consume(std::min(skip, bufBits_));
+    }
+}
+
+void BitReader::readFields(uint32_t* out, size_t count, int numBits) {
+    if (numBits <= 0) {
+        std::fill(out, out + count, 0);
+        return;
+    }
+
+    size_t start = bitPosition();
+    size_t end = start + count * numBits;
+    size_t totalBits = size_ * 8;
+
+    // Fields whose 8-byte window lies inside the data unpack with one
+    // unaligned load and two shifts each, with no branches
+    size_t fast = 0;
+    if (size_ >= 8) {
+        size_t lastSafe = (size_ - 8) * 8;
+        fast = start <= lastSafe ? std::min(count, (lastSafe - start) / numBits + 1) : 0;
+    }
+    for (size_t i = 0; i < fast; i++) {
+        size_t pos = start + i * numBits;
+        uint64_t word;
+        std::memcpy(&word, data_ + pos / 8, 8);
+        word = fromBigEndian(word);
+        out[i] = static_cast<uint32_t>((word << (pos % 8)) >> (64 - numBits));
     }
-    return result;
+
+    // Tail fields near the end of data, with zeros past it
+    seek(start + fast * numBits);
+    for (size_t i = fast; i < count; i++) {
+        out[i] = readBits(numBits);
+    }
+    if (end <= totalBits) {
+        seek(end);
+    }
+}
+
+int BitReader::readUnary(int limit) {
+    if (bufBits_ <= limit) {
+        refill();
+    }
+    // Bits past bufBits_ may be set, so only trust a one bit inside it
+    int zeros = std::min(leadingZeros(buf_), limit);
+    if (zeros < limit && zeros < bufBits_) {
+        consume(zeros + 1);
+        return zeros;
+    }
+    if (zeros == limit && limit <= bufBits_) {
+        consume(limit);
+        return limit;
+    }
+    overrun_ = true;
+    buf_ = 0;
+    bufBits_ = 0;
+    return limit;
 }
 
 bool BitReader::readBoolean() {
@@ -88,39 +244,44 @@ bool BitReader::readBoolean() {
 
 int32_t BitReader::readInt(bool isSigned, int numBits) {
     uint32_t value = readBits(numBits);
-    if (isSigned && (value & (1u << (numBits - 1)))) {
-        // Sign extend
+    if (isSigned && numBits > 0 && numBits < 32 && (value & (1u << (numBits - 1)))) {
+        // Sign extend; a 32-bit field already fills the value
         value |= ~((1u << numBits) - 1);
     }
     return static_cast<int32_t>(value);
 }
 
 uint8_t BitReader::readByte() {
-    if (bitPos_ == 0 && bytePos_ < size_) {
-        return data_[bytePos_++];
-    }
     return static_cast<uint8_t>(readBits(8));
 }
 
 void BitReader::readBytes(uint8_t* buffer, size_t count) {
-    for (size_t i = 0; i < count; i++) {
+    size_t i = 0;
+    if (bufBits_ % 8 == 0) {
+        // Byte aligned: drain the bit buffer, then copy straight through
+        for (; i < count && bufBits_ > 0; i++) {
+            buffer[i] = static_cast<uint8_t>(peek(8));
+            consume(8);
+        }
+        size_t direct = std::min(count - i, size_ - bytePos_);
+        if (direct > 0) {
+            std::memcpy(buffer + i, data_ + bytePos_, direct);
+            bytePos_ += direct;
+            i += direct;
+            buf_ = 0;
+        }
+    }
+    for (; i < count; i++) {
         buffer[i] = readByte();
     }
 }
 
 void BitReader::align() {
-    if (bitPos_ != 0) {
-        bytePos_++;
-        bitPos_ = 0;
-    }
+    consume(bufBits_ % 8);
 }
 
 size_t BitReader::bytesRemaining() const {
-    size_t remaining = size_ - bytePos_;
-    if (bitPos_ > 0 && remaining > 0) {
-        remaining--;
-    }
-    return remaining;
+    return (size_ - bytePos_) + bufBits_ / 8;
 }
 
 } // namespace glic
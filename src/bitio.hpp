@@ -3,12 +3,62 @@
 #include <cstdint>
 #include <vector>
 #include <cstddef>
+#include <algorithm>
+#include <functional>
 
 namespace glic {
 
+// Destination for encoded bytes. Seekable sinks can rewrite earlier output,
+// which lets the encoder back-patch header fields. Image data reaches the
+// sink as it is coded, holding at most one rANS block; the segmentation
+// and prediction sections and LAYERED image data are built whole first.
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+
+    virtual void write(const uint8_t* data, size_t size) = 0;
+    virtual bool seekable() const { return false; }
+    // Overwrite bytes written earlier; only called when seekable()
+    virtual void patch(size_t, const uint8_t*, size_t) {}
+};
+
+// Appends to a vector
+class VectorSink : public ByteSink {
+public:
+    explicit VectorSink(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        buffer_.insert(buffer_.end(), data, data + size);
+    }
+    bool seekable() const override { return true; }
+    void patch(size_t offset, const uint8_t* data, size_t size) override {
+        std::copy(data, data + size, buffer_.begin() + offset);
+    }
+
+private:
+    std::vector<uint8_t>& buffer_;
+};
+
+// Hands every chunk to a callback (sockets, pipes, ...); not seekable
+class CallbackSink : public ByteSink {
+public:
+    using Callback = std::function<void(const uint8_t*, size_t)>;
+
+    explicit CallbackSink(Callback callback) : callback_(std::move(callback)) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        callback_(data, size);
+    }
+
+private:
+    Callback callback_;
+};
+
+// MSB-first bit writer. Bits collect in a 64-bit accumulator and are
+// flushed to the buffer a 32-bit word at a time.
 class BitWriter {
 public:
-    BitWriter() : buffer_(), bitPos_(0), currentByte_(0) {}
+    BitWriter() : buffer_(), acc_(0), accBits_(0) {}
 
     void writeBit(bool bit);
     void writeBits(uint32_t value, int numBits);
@@ -17,38 +67,109 @@ public:
     void writeByte(uint8_t value);
     void writeBytes(const uint8_t* data, size_t size);
 
+    // Size hint: reserve room for this many output bytes up front
+    void reserve(size_t bytes) { buffer_.reserve(bytes); }
+
+    // Stream complete bytes to a sink in chunks instead of keeping them;
+    // data() then holds only what has not been handed over yet
+    void setOutput(ByteSink* sink) { out_ = sink; }
+    // Hand every complete byte to the output sink
+    void flushOutput();
+
     void align();
-    const std::vector<uint8_t>& data() const { return buffer_; }
-    size_t size() const { return buffer_.size(); }
+    // Complete bytes written so far; a trailing partial byte needs align()
+    const std::vector<uint8_t>& data() const { flushBytes(); return buffer_; }
+    size_t size() const { flushBytes(); return buffer_.size(); }
     void clear();
 
 private:
-    std::vector<uint8_t> buffer_;
-    int bitPos_;
-    uint8_t currentByte_;
+    // Output is handed to the sink once this much has collected
+    static constexpr size_t STREAM_CHUNK = 1 << 16;
+
+    void flushWord();
+    void flushBytes() const;
+    void drain();
+
+    // Complete bytes are moved out of the accumulator lazily, including
+    // from the const accessors
+    mutable std::vector<uint8_t> buffer_;
+    mutable uint64_t acc_;  // pending bits in the low accBits_ bits
+    mutable int accBits_;   // below 32 between calls
+    ByteSink* out_ = nullptr;
+};
+
+// Bit sink with the BitWriter interface that only tallies bits. Used to
+// cost an encoding exactly without producing any output; encoders size
+// their payloads instead of building them, so costing allocates only
+// small per-channel tables (symbol counts, code lengths, frequencies).
+class BitCounter {
+public:
+    void writeBit(bool) { bits_++; }
+    void writeBits(uint32_t, int numBits) { bits_ += numBits > 0 ? numBits : 0; }
+    void writeBoolean(bool) { bits_++; }
+    void writeInt(int32_t, bool, int numBits) { writeBits(0, numBits); }
+    void writeByte(uint8_t) { bits_ += 8; }
+    void writeBytes(const uint8_t*, size_t size) { bits_ += size * 8; }
+    // Account for bits an encoder sized without writing them
+    void addBits(uint64_t numBits) { bits_ += numBits; }
+
+    void reserve(size_t) {}
+    void align() { bits_ = (bits_ + 7) & ~uint64_t(7); }
+    // Complete bytes, as BitWriter::size() would report
+    size_t size() const { return static_cast<size_t>(bits_ / 8); }
+    uint64_t bits() const { return bits_; }
+    void clear() { bits_ = 0; }
+
+private:
+    uint64_t bits_ = 0;
 };
 
+// MSB-first bit reader over a 64-bit bit buffer. Reads never throw: reading
+// past the end yields zero bits and sets a sticky overrun flag, which
+// callers check once per segment or record.
 class BitReader {
 public:
     BitReader(const uint8_t* data, size_t size)
-        : data_(data), size_(size), bytePos_(0), bitPos_(0) {}
+        : data_(data), size_(size), bytePos_(0), buf_(0), bufBits_(0), overrun_(false) {}
+
+    // Top up the bit buffer to at least 56 bits while input remains
+    void refill();
+    // Next numBits (0-32) without consuming them; needs a prior refill()
+    uint32_t peek(int numBits) const { return static_cast<uint32_t>((buf_ >> 1) >> (63 - numBits)); }
+    // Drop numBits (at most what is buffered) from the bit buffer
+    void consume(int numBits) { buf_ <<= numBits; bufBits_ -= numBits; }
 
     bool readBit();
     uint32_t readBits(int numBits);
+    // Bulk unpack of count fixed-width fields (0-32 bits each)
+    void readFields(uint32_t* out, size_t count, int numBits);
+    // Unary prefix: count zero bits (at most limit, up to 32) and consume
+    // them with the terminating one bit; a run reaching limit consumes only
+    // the zeros and returns limit
+    int readUnary(int limit);
     bool readBoolean();
     int32_t readInt(bool isSigned, int numBits);
     uint8_t readByte();
     void readBytes(uint8_t* buffer, size_t count);
 
     void align();
-    bool eof() const { return bytePos_ >= size_ && bitPos_ == 0; }
+    bool eof() const { return bytePos_ >= size_ && bufBits_ == 0; }
+    bool overrun() const { return overrun_; }
+    // Bits currently held in the bit buffer
+    int buffered() const { return bufBits_; }
     size_t bytesRemaining() const;
 
 private:
+    // Absolute position in bits of the next unread bit
+    size_t bitPosition() const { return bytePos_ * 8 - bufBits_; }
+    void seek(size_t bitPos);
+
     const uint8_t* data_;
     size_t size_;
-    size_t bytePos_;
-    int bitPos_;
+    size_t bytePos_;  // next byte not yet in the bit buffer
+    uint64_t buf_;    // buffered bits, MSB first
+    int bufBits_;
+    bool overrun_;
 };
 
 } // namespace glic
@@ -682,6 +682,7 @@ std::string waveletName(WaveletType wt) {
         case WaveletType::COIFLET3: return "COIFLET3";
         case WaveletType::COIFLET4: return "COIFLET4";
         case WaveletType::COIFLET5: return "COIFLET5";
+        case WaveletType::LEGALL53: return "LEGALL53";
         default: return "NONE";
     }
 }
@@ -713,6 +714,7 @@ WaveletType waveletFromName(const std::string& name) {
     if (name == "COIFLET3" || name == "COIF3") return WaveletType::COIFLET3;
     if (name == "COIFLET4" || name == "COIF4") return WaveletType::COIFLET4;
     if (name == "COIFLET5" || name == "COIF5") return WaveletType::COIFLET5;
+    if (name == "LEGALL53" || name == "LG53") return WaveletType::LEGALL53;
     return WaveletType::NONE;
 }
 
@@ -724,6 +726,13 @@ std::string encodingName(EncodingMethod em) {
         case EncodingMethod::DELTA: return "DELTA";
         case EncodingMethod::XOR: return "XOR";
         case EncodingMethod::ZIGZAG: return "ZIGZAG";
+        case EncodingMethod::RANS: return "RANS";
+        case EncodingMethod::RICE: return "RICE";
+        case EncodingMethod::HUFFMAN: return "HUFFMAN";
+        case EncodingMethod::BLOCKPACK: return "BLOCKPACK";
+        case EncodingMethod::SIGMAP: return "SIGMAP";
+        case EncodingMethod::LAYERED: return "LAYERED";
+        case EncodingMethod::AUTO: return "AUTO";
         default: return "RAW";
     }
 }
@@ -735,6 +744,13 @@ EncodingMethod encodingFromName(const std::string& name) {
     if (name == "DELTA") return EncodingMethod::DELTA;
     if (name == "XOR") return EncodingMethod::XOR;
     if (name == "ZIGZAG") return EncodingMethod::ZIGZAG;
+    if (name == "RANS") return EncodingMethod::RANS;
+    if (name == "RICE") return EncodingMethod::RICE;
+    if (name == "HUFFMAN") return EncodingMethod::HUFFMAN;
+    if (name == "BLOCKPACK") return EncodingMethod::BLOCKPACK;
+    if (name == "SIGMAP") return EncodingMethod::SIGMAP;
+    if (name == "LAYERED") return EncodingMethod::LAYERED;
+    if (name == "AUTO") return EncodingMethod::AUTO;
     return EncodingMethod::RAW;
 }
 
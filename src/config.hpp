@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <array>
 #include <string>
+#include <vector>
 
 namespace glic {
 
@@ -77,7 +78,8 @@ enum class TransformType : uint8_t {
     RANDOM = 255,
     FWT = 0,
     WPT = 1,
-    COUNT = 2
+    LIFTING = 2,    // Integer-reversible lifting (LeGall 5/3)
+    COUNT = 3
 };
 
 // Wavelet types
@@ -124,7 +126,8 @@ enum class WaveletType : uint8_t {
     DAUBECHIES9 = 38,
     DAUBECHIES10 = 39,
     HAAR = 40,
-    COUNT = 41
+    LEGALL53 = 41,  // Integer 5/3, always used with TransformType::LIFTING
+    COUNT = 42
 };
 
 std::string waveletName(WaveletType wt);
@@ -139,7 +142,20 @@ enum class EncodingMethod : uint8_t {
     DELTA = 3,
     XOR = 4,
     ZIGZAG = 5,
-    COUNT = 6
+    // Entropy-coded methods
+    RANS = 6,
+    RICE = 7,
+    HUFFMAN = 8,
+    // Per-segment frame-of-reference packing
+    BLOCKPACK = 9,
+    // Significance map of subband coefficients
+    SIGMAP = 10,
+    COUNT = 11,
+    // Progressive bit-plane quality layers, written by the container
+    // (not a per-channel method for encodeData or AUTO)
+    LAYERED = 0xFE,
+    // Encoder only: pick the smallest method per channel; never stored
+    AUTO = 0xFF
 };
 
 std::string encodingName(EncodingMethod em);
@@ -158,6 +174,8 @@ struct ChannelConfig {
     float transformCompress = 0.0f;
     int transformScale = 20;
     EncodingMethod encodingMethod = EncodingMethod::PACKED;
+    int coefficientBits = 0;  // Signed width of stored lifting coefficients, set by the encoder
+    std::vector<uint8_t> codeLengths;  // HUFFMAN code lengths, set by the encoder
 };
 
 // Full codec configuration
@@ -175,6 +193,29 @@ struct CodecConfig {
     }
 };
 
+// Decoder options
+struct DecodeOptions {
+    // Decode only this channel (0-2) as a grayscale image of its stored
+    // values, reading none of the other channels' sections; -1 for all
+    int channel = -1;
+
+    // With useRegion, decode only this rectangle, which must be non-empty
+    // and inside the image. Only the segments the region's predictions
+    // depend on are reconstructed, and only the region is color converted.
+    bool useRegion = false;
+    int regionX = 0;
+    int regionY = 0;
+    int regionWidth = 0;
+    int regionHeight = 0;
+
+    // Decode a thumbnail at 1/downscale of the size (a power of two). Each
+    // segment is reconstructed at that scale from its transform's low band,
+    // without decoding the full image first; predictions read the reduced
+    // neighbours, so it approximates a downscaled full decode. Not combined
+    // with a region.
+    int downscale = 1;
+};
+
 // Color type (ARGB packed)
 using Color = uint32_t;
 
@@ -0,0 +1,237 @@
+#include "container.hpp"
+#include "encoding.hpp"
+#include <algorithm>
+
+namespace glic {
+
+namespace {
+
+void appendU16(std::vector<uint8_t>& buffer, uint16_t v) {
+    buffer.push_back((v >> 8) & 0xFF);
+    buffer.push_back(v & 0xFF);
+}
+
+void appendU32(std::vector<uint8_t>& buffer, uint32_t v) {
+    appendU16(buffer, static_cast<uint16_t>(v >> 16));
+    appendU16(buffer, static_cast<uint16_t>(v));
+}
+
+void appendU64(std::vector<uint8_t>& buffer, uint64_t v) {
+    appendU32(buffer, static_cast<uint32_t>(v >> 32));
+    appendU32(buffer, static_cast<uint32_t>(v));
+}
+
+uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t readU32(const uint8_t* p) {
+    return (static_cast<uint32_t>(readU16(p)) << 16) | readU16(p + 2);
+}
+
+uint64_t readU64(const uint8_t* p) {
+    return (static_cast<uint64_t>(readU32(p)) << 32) | readU32(p + 4);
+}
+
+// Header layout of version 2 (sizes live in the section table)
+constexpr size_t SECTION_COUNT_POS = 18;
+constexpr size_t SECTION_TABLE_POS = 20;
+constexpr size_t FLAGS_POS = 54;
+// Header layout of version 1
+constexpr size_t V1_SIZES_POS = 18;
+
+// Version 1 sections follow the channel headers in a fixed order, with
+// uint32 sizes in the header: all segmentation, then all prediction, then
+// all image data
+void readVersion1Layout(const uint8_t* data, ContainerInfo& info) {
+    const SectionKind kinds[3] = {SectionKind::SEGMENTATION, SectionKind::PREDICTION, SectionKind::DATA};
+    size_t pos = sectionTableOffset();
+    for (int k = 0; k < 3; k++) {
+        for (int p = 0; p < 3; p++) {
+            uint32_t length = readU32(data + V1_SIZES_POS + 12 * k + 4 * p);
+            info.sections.push_back({kinds[k], static_cast<uint8_t>(p), 0, pos, length});
+            pos += length;
+        }
+    }
+}
+
+} // anonymous namespace
+
+const Section* ContainerInfo::find(SectionKind kind, int channel, int index) const {
+    for (const auto& section : sections) {
+        if (section.kind == kind && section.channel == channel && section.index == index) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
+
+int ContainerInfo::dataSections(int channel) const {
+    int count = 0;
+    while (find(SectionKind::DATA, channel, count)) {
+        count++;
+    }
+    return count;
+}
+
+std::vector<uint8_t> writeSectionTable(const std::vector<Section>& sections) {
+    std::vector<uint8_t> buffer;
+    buffer.reserve(sections.size() * GLIC_SECTION_ENTRY_SIZE);
+    for (const auto& section : sections) {
+        buffer.push_back(static_cast<uint8_t>(section.kind));
+        buffer.push_back(section.channel);
+        appendU16(buffer, section.index);
+        appendU64(buffer, section.offset);
+        appendU64(buffer, section.length);
+    }
+    return buffer;
+}
+
+std::vector<uint8_t> writeContainerHeader(const ContainerInfo& info) {
+    bool trailer = (info.flags & GLIC_FLAG_SIZE_TRAILER) != 0;
+    std::vector<uint8_t> buffer;
+
+    // Magic + version
+    appendU32(buffer, GLIC_MAGIC);
+    appendU16(buffer, GLIC_VERSION);
+
+    // Width and height
+    appendU32(buffer, static_cast<uint32_t>(info.width));
+    appendU32(buffer, static_cast<uint32_t>(info.height));
+
+    // Color space and border color
+    buffer.push_back(static_cast<uint8_t>(info.colorSpace));
+    buffer.insert(buffer.end(), info.border, info.border + 3);
+
+    // Section count and table position (zero when in a trailer)
+    appendU16(buffer, static_cast<uint16_t>(info.sections.size()));
+    appendU64(buffer, trailer ? 0 : sectionTableOffset());
+
+    // Flags
+    buffer.resize(FLAGS_POS, 0);
+    buffer.push_back(info.flags);
+
+    // Pad header to 64 bytes
+    buffer.resize(GLIC_HEADER_SIZE, 0);
+
+    // Channel configs (32 bytes each)
+    for (int p = 0; p < 3; p++) {
+        const auto& ch = info.channels[p];
+        size_t start = buffer.size();
+        buffer.push_back(static_cast<uint8_t>(ch.predictionMethod));
+        buffer.push_back(static_cast<uint8_t>(ch.quantizationValue));
+        buffer.push_back(static_cast<uint8_t>(ch.clampMethod));
+        buffer.push_back(static_cast<uint8_t>(ch.waveletType));
+        buffer.push_back(static_cast<uint8_t>(ch.transformType));
+        appendU32(buffer, static_cast<uint32_t>(ch.transformScale));
+        buffer.push_back(static_cast<uint8_t>(ch.encodingMethod));
+        buffer.push_back(static_cast<uint8_t>(ch.coefficientBits));
+
+        // Huffman code lengths: count, then two 4-bit lengths per byte
+        buffer.push_back(static_cast<uint8_t>(ch.codeLengths.size()));
+        for (size_t i = 0; i < ch.codeLengths.size(); i += 2) {
+            uint8_t lo = i + 1 < ch.codeLengths.size() ? ch.codeLengths[i + 1] : 0;
+            buffer.push_back(static_cast<uint8_t>((ch.codeLengths[i] << 4) | lo));
+        }
+
+        // Pad, then the bit-plane count of LAYERED channels in the last byte
+        buffer.resize(start + GLIC_CHANNEL_HEADER_SIZE - 1, 0);
+        buffer.push_back(static_cast<uint8_t>(info.bitPlanes[p]));
+    }
+
+    if (!trailer) {
+        auto table = writeSectionTable(info.sections);
+        buffer.insert(buffer.end(), table.begin(), table.end());
+    }
+    return buffer;
+}
+
+bool readContainer(const uint8_t* data, size_t size, ContainerInfo& info, std::string& error,
+                   bool readSections) {
+    if (size < sectionTableOffset()) {
+        error = "Buffer too small";
+        return false;
+    }
+
+    if (readU32(data) != GLIC_MAGIC) {
+        error = "Invalid file format";
+        return false;
+    }
+
+    info.version = readU16(data + 4);
+    if (info.version < 1 || info.version > GLIC_VERSION) {
+        error = "Unsupported file version";
+        return false;
+    }
+
+    // Checked before anything is sized from them
+    uint32_t width = readU32(data + 6);
+    uint32_t height = readU32(data + 10);
+    if (!validDimensions(width, height)) {
+        error = "Invalid image dimensions";
+        return false;
+    }
+    info.width = static_cast<int>(width);
+    info.height = static_cast<int>(height);
+    info.colorSpace = static_cast<ColorSpace>(data[14]);
+    std::copy(data + 15, data + 18, info.border);
+    info.flags = info.version == 1 ? 0 : data[FLAGS_POS];
+
+    // Channel configs
+    for (int p = 0; p < 3; p++) {
+        const uint8_t* ch = data + GLIC_HEADER_SIZE + p * GLIC_CHANNEL_HEADER_SIZE;
+        auto& config = info.channels[p];
+        config = ChannelConfig();
+        config.predictionMethod = static_cast<PredictionMethod>(static_cast<int8_t>(ch[0]));
+        config.quantizationValue = ch[1];
+        config.clampMethod = static_cast<ClampMethod>(ch[2]);
+        config.waveletType = static_cast<WaveletType>(ch[3]);
+        config.transformType = static_cast<TransformType>(ch[4]);
+        config.transformScale = static_cast<int>(readU32(ch + 5));
+        config.encodingMethod = static_cast<EncodingMethod>(ch[9]);
+        config.coefficientBits = ch[10];
+
+        size_t lengthCount = std::min<size_t>(ch[11], HUFFMAN_SYMBOLS);
+        for (size_t i = 0; i < lengthCount; i++) {
+            uint8_t packed = ch[12 + i / 2];
+            config.codeLengths.push_back(i % 2 == 0 ? packed >> 4 : packed & 0x0F);
+        }
+
+        info.bitPlanes[p] = info.version == 1 ? 0 : ch[GLIC_CHANNEL_HEADER_SIZE - 1];
+    }
+
+    info.sections.clear();
+    if (!readSections) {
+        return true;
+    }
+    if (info.version == 1) {
+        readVersion1Layout(data, info);
+        return true;
+    }
+
+    // Section table, after the channel headers or at the end of the file
+    size_t count = readU16(data + SECTION_COUNT_POS);
+    size_t tableSize = count * GLIC_SECTION_ENTRY_SIZE;
+    uint64_t tablePos = readU64(data + SECTION_TABLE_POS);
+    if (info.flags & GLIC_FLAG_SIZE_TRAILER) {
+        tablePos = size >= sectionTableOffset() + tableSize ? size - tableSize : size;
+    }
+    if (tablePos > size || size - tablePos < tableSize) {
+        error = "Truncated file";
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* entry = data + tablePos + i * GLIC_SECTION_ENTRY_SIZE;
+        Section section;
+        section.kind = static_cast<SectionKind>(entry[0]);
+        section.channel = entry[1];
+        section.index = readU16(entry + 2);
+        section.offset = readU64(entry + 4);
+        section.length = readU64(entry + 12);
+        info.sections.push_back(section);
+    }
+    return true;
+}
+
+} // namespace glic
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "config.hpp"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace glic {
+
+// File format constants
+constexpr uint32_t GLIC_MAGIC = 0x474C4332; // "GLC2"
+// 1: fixed layout, raw split flags and 8-byte prediction records, still
+// read; 2: section table, skip flags, range-coded split flags, compact
+// prediction data, header flags and progressive layers
+constexpr uint16_t GLIC_VERSION = 2;
+// Header flag: image data is stored as interleaved quality layers
+constexpr uint8_t GLIC_FLAG_LAYERED = 0x01;
+// Header flag: the section table follows the data instead (output that
+// could not be seeked back)
+constexpr uint8_t GLIC_FLAG_SIZE_TRAILER = 0x02;
+// Largest image a file may declare, per side and in total. Headers outside
+// these are rejected as corrupt before anything is allocated for them.
+constexpr int GLIC_MAX_DIMENSION = 65535;
+constexpr uint64_t GLIC_MAX_PIXELS = uint64_t(1) << 28;
+constexpr size_t GLIC_HEADER_SIZE = 64;
+constexpr size_t GLIC_CHANNEL_HEADER_SIZE = 32;
+constexpr size_t GLIC_SECTION_ENTRY_SIZE = 20;
+
+// Kinds of section. Readers skip kinds they do not know, so new ones can
+// be added without a version bump.
+enum class SectionKind : uint8_t {
+    SEGMENTATION = 1,
+    PREDICTION = 2,
+    DATA = 3        // index is the quality layer for LAYERED channels
+};
+
+// Section table entry: kind, channel and index, then the 64-bit offset
+// from the start of the file and length
+struct Section {
+    SectionKind kind;
+    uint8_t channel = 0;
+    uint16_t index = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+// Everything in a file ahead of the section payloads
+struct ContainerInfo {
+    uint16_t version = GLIC_VERSION;
+    uint8_t flags = 0;
+    int width = 0;
+    int height = 0;
+    ColorSpace colorSpace = ColorSpace::RGB;
+    uint8_t border[3] = {128, 128, 128};
+    std::array<ChannelConfig, 3> channels;
+    int bitPlanes[3] = {0, 0, 0};
+    std::vector<Section> sections;
+
+    // Section of a kind for a channel, or null
+    const Section* find(SectionKind kind, int channel, int index = 0) const;
+
+    // Number of DATA sections of a channel
+    int dataSections(int channel) const;
+};
+
+// Width and height within the limits above
+inline bool validDimensions(int64_t width, int64_t height) {
+    return width > 0 && height > 0 && width <= GLIC_MAX_DIMENSION && height <= GLIC_MAX_DIMENSION &&
+           static_cast<uint64_t>(width) * static_cast<uint64_t>(height) <= GLIC_MAX_PIXELS;
+}
+
+// Header and channel headers, followed by the section table unless it goes
+// in a trailer. Table entries not yet known can be patched in later at
+// sectionTableOffset() with writeSectionTable().
+std::vector<uint8_t> writeContainerHeader(const ContainerInfo& info);
+std::vector<uint8_t> writeSectionTable(const std::vector<Section>& sections);
+constexpr size_t sectionTableOffset() {
+    return GLIC_HEADER_SIZE + 3 * GLIC_CHANNEL_HEADER_SIZE;
+}
+
+// Parse the header, channel headers and section table. Version 1 files
+// have their fixed layout turned into sections. Sections are not
+// checked against the size, so truncated files can be partly decoded.
+// Without readSections only the first sectionTableOffset() bytes are read.
+bool readContainer(const uint8_t* data, size_t size, ContainerInfo& info, std::string& error,
+                   bool readSections = true);
+
+} // namespace glic
@@ -1,6 +1,15 @@
 #include "encoding.hpp"
+#include "huffman.hpp"
+#include "rangecoder.hpp"
+#include "rans.hpp"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
 
 namespace glic {
 
@@ -10,35 +19,67 @@ int calcBits(int scale) {
     return static_cast<int>(std::ceil(std::log(static_cast<float>(scale)) / std::log(2.0f)));
 }
 
-void emitPackedBits(BitWriter& writer, int channel, int bits, int val, const ChannelConfig& config) {
+// Magnitude bits of a stored value; values are written in bits + 1 bits
+int packedBits(const ChannelConfig& config) {
+    if (config.coefficientBits > 0) {
+        return config.coefficientBits - 1;
+    }
+    return calcBits(config.transformScale);
+}
+
+// Width and signedness of one stored value. Values are truncated to the
+// width on write and read back as stored (unsigned fields do not recover
+// negative values).
+struct PackedField {
+    int width;
+    bool isSigned;
+};
+
+PackedField packedField(int bits, const ChannelConfig& config) {
     if (config.waveletType == WaveletType::NONE) {
-        if (config.clampMethod == ClampMethod::NONE) {
-            writer.writeInt(val, false, 9);
-        } else if (config.clampMethod == ClampMethod::MOD256) {
-            writer.writeInt(val, true, 8);
+        if (config.clampMethod == ClampMethod::MOD256) {
+            return {8, true};
         }
-    } else {
-        writer.writeInt(val, false, bits + 1);
+        return {9, false};
+    } else if (config.coefficientBits > 0) {
+        return {config.coefficientBits, true};
     }
+    return {bits + 1, false};
+}
+
+template <typename Sink>
+void emitPackedBits(Sink& writer, int channel, int bits, int val, const ChannelConfig& config) {
+    PackedField field = packedField(bits, config);
+    writer.writeInt(val, field.isSigned, field.width);
 }
 
 int readPackedBits(BitReader& reader, int channel, int bits, const ChannelConfig& config) {
-    if (config.waveletType == WaveletType::NONE) {
-        if (config.clampMethod == ClampMethod::NONE) {
-            return reader.readInt(false, 9);
-        } else if (config.clampMethod == ClampMethod::MOD256) {
-            return reader.readInt(true, 8);
-        }
-    } else {
-        return reader.readInt(false, bits + 1);
+    PackedField field = packedField(bits, config);
+    return reader.readInt(field.isSigned, field.width);
+}
+
+// Bulk decoders unpack a segment's fields into a buffer and finish them with
+// the branch-free loops below, which the compiler vectorises
+void signExtendFields(uint32_t* fields, size_t count, int width) {
+    int shift = 32 - width;
+    for (size_t i = 0; i < count; i++) {
+        fields[i] = static_cast<uint32_t>(static_cast<int32_t>(fields[i] << shift) >> shift);
     }
-    return 0;
+}
+
+size_t sampleCount(const std::vector<Segment>& segments) {
+    size_t count = 0;
+    for (const auto& seg : segments) {
+        count += static_cast<size_t>(seg.size) * seg.size;
+    }
+    return count;
 }
 
 } // anonymous namespace
 
+template <typename Sink>
 void encodeData(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
@@ -61,6 +102,21 @@ void encodeData(
         case EncodingMethod::ZIGZAG:
             encodeZigzag(writer, planes, channel, segments, config);
             break;
+        case EncodingMethod::RANS:
+            encodeRANS(writer, planes, channel, segments, config);
+            break;
+        case EncodingMethod::RICE:
+            encodeRice(writer, planes, channel, segments, config);
+            break;
+        case EncodingMethod::HUFFMAN:
+            encodeHuffman(writer, planes, channel, segments, config);
+            break;
+        case EncodingMethod::BLOCKPACK:
+            encodeBlockPacked(writer, planes, channel, segments, config);
+            break;
+        case EncodingMethod::SIGMAP:
+            encodeSigMap(writer, planes, channel, segments, config);
+            break;
         case EncodingMethod::RAW:
         default:
             encodeRaw(writer, planes, channel, segments);
@@ -68,6 +124,57 @@ void encodeData(
     }
 }
 
+EncodingMethod chooseEncoding(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    constexpr int methodCount = static_cast<int>(EncodingMethod::COUNT);
+
+    // RAW and PACKED write every sample at a fixed width
+    uint64_t samples = sampleCount(segments);
+    std::vector<uint64_t> costs(methodCount);
+    costs[static_cast<int>(EncodingMethod::RAW)] = samples * 32;
+    costs[static_cast<int>(EncodingMethod::PACKED)] =
+        (samples * packedField(packedBits(config), config).width + 7) & ~uint64_t(7);
+
+    // The rest are counted by at most one worker per hardware thread, each
+    // taking the next uncounted method
+    constexpr int firstCounted = static_cast<int>(EncodingMethod::RLE);
+    std::atomic<int> next(firstCounted);
+    auto work = [&] {
+        for (int m = next++; m < methodCount; m = next++) {
+            BitCounter counter;
+            encodeData(counter, planes, channel, segments, static_cast<EncodingMethod>(m), config);
+            counter.align();
+            costs[m] = counter.bits();
+        }
+    };
+    unsigned workers = std::min(std::max(std::thread::hardware_concurrency(), 1u),
+                                static_cast<unsigned>(methodCount - firstCounted));
+    std::vector<std::future<void>> pool;
+    for (unsigned i = 1; i < workers; i++) {
+        pool.push_back(std::async(std::launch::async, work));
+    }
+    work();
+    for (auto& f : pool) {
+        f.get();
+    }
+
+    // Ties keep the lower-numbered (simpler) method
+    EncodingMethod best = EncodingMethod::RAW;
+    uint64_t bestBits = std::numeric_limits<uint64_t>::max();
+    for (int m = 0; m < methodCount; m++) {
+        uint64_t bits = costs[m];
+        if (bits < bestBits) {
+            bestBits = bits;
+            best = static_cast<EncodingMethod>(m);
+        }
+    }
+    return best;
+}
+
 void decodeData(
     BitReader& reader,
     Planes& planes,
@@ -92,6 +199,21 @@ void decodeData(
         case EncodingMethod::ZIGZAG:
             decodeZigzag(reader, planes, channel, segments, config);
             break;
+        case EncodingMethod::RANS:
+            decodeRANS(reader, planes, channel, segments, config);
+            break;
+        case EncodingMethod::RICE:
+            decodeRice(reader, planes, channel, segments, config);
+            break;
+        case EncodingMethod::HUFFMAN:
+            decodeHuffman(reader, planes, channel, segments, config);
+            break;
+        case EncodingMethod::BLOCKPACK:
+            decodeBlockPacked(reader, planes, channel, segments, config);
+            break;
+        case EncodingMethod::SIGMAP:
+            decodeSigMap(reader, planes, channel, segments, config);
+            break;
         case EncodingMethod::RAW:
         default:
             decodeRaw(reader, planes, channel, segments, 0);
@@ -99,8 +221,9 @@ void decodeData(
     }
 }
 
+template <typename Sink>
 void encodeRaw(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments
@@ -117,14 +240,15 @@ void encodeRaw(
     writer.align();
 }
 
+template <typename Sink>
 void encodePacked(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
 
     for (const auto& seg : segments) {
         for (int x = 0; x < seg.size; x++) {
@@ -137,14 +261,15 @@ void encodePacked(
     writer.align();
 }
 
+template <typename Sink>
 void encodeRLE(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
     int currentVal = 0;
     bool firstVal = true;
     int currentCnt = 0;
@@ -164,7 +289,7 @@ void encodeRLE(
                             writer.writeBoolean(false);
                         } else {
                             writer.writeBoolean(true);
-                            writer.writeInt(currentCnt - 2, true, 7);
+                            writer.writeInt(currentCnt - 2, false, 7);
                         }
                         emitPackedBits(writer, channel, bits, currentVal, config);
                         currentVal = val;
@@ -183,7 +308,7 @@ void encodeRLE(
             writer.writeBoolean(false);
         } else {
             writer.writeBoolean(true);
-            writer.writeInt(currentCnt - 2, true, 7);
+            writer.writeInt(currentCnt - 2, false, 7);
         }
         emitPackedBits(writer, channel, bits, currentVal, config);
     }
@@ -201,15 +326,14 @@ void decodeRaw(
     for (const auto& seg : segments) {
         for (int x = 0; x < seg.size; x++) {
             for (int y = 0; y < seg.size; y++) {
-                try {
-                    int val = static_cast<int32_t>(reader.readBits(32));
-                    planes.set(channel, seg.x + x, seg.y + y, val);
-                } catch (...) {
-                    // EOF reached
-                    return;
-                }
+                int val = static_cast<int32_t>(reader.readBits(32));
+                planes.set(channel, seg.x + x, seg.y + y, val);
             }
         }
+        // Reads past the end yield zeros; stop after the segment
+        if (reader.overrun()) {
+            return;
+        }
     }
     reader.align();
 }
@@ -221,19 +345,18 @@ void decodePacked(
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    PackedField field = packedField(packedBits(config), config);
+    std::vector<uint32_t> fields;
 
     for (const auto& seg : segments) {
-        for (int x = 0; x < seg.size; x++) {
-            for (int y = 0; y < seg.size; y++) {
-                try {
-                    int val = readPackedBits(reader, channel, bits, config);
-                    planes.set(channel, seg.x + x, seg.y + y, val);
-                } catch (...) {
-                    // EOF reached
-                    return;
-                }
-            }
+        fields.resize(static_cast<size_t>(seg.size) * seg.size);
+        reader.readFields(fields.data(), fields.size(), field.width);
+        if (field.isSigned) {
+            signExtendFields(fields.data(), fields.size(), field.width);
+        }
+        planes.setBlock(channel, seg, reinterpret_cast<const int32_t*>(fields.data()));
+        if (reader.overrun()) {
+            return;
         }
     }
     reader.align();
@@ -246,7 +369,7 @@ void decodeRLE(
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
     int currentVal = 0;
     bool doReadType = true;
     int currentCnt = 0;
@@ -254,25 +377,23 @@ void decodeRLE(
     for (const auto& seg : segments) {
         for (int x = 0; x < seg.size; x++) {
             for (int y = 0; y < seg.size; y++) {
-                try {
-                    if (doReadType) {
-                        if (reader.readBoolean()) {
-                            currentCnt = reader.readInt(true, 7) + 2;
-                            doReadType = false;
-                        }
-                        currentVal = readPackedBits(reader, channel, bits, config);
+                if (doReadType) {
+                    if (reader.readBoolean()) {
+                        currentCnt = reader.readInt(false, 7) + 2;
+                        doReadType = false;
                     }
-                    planes.set(channel, seg.x + x, seg.y + y, currentVal);
-                    currentCnt--;
-                    if (currentCnt <= 0) {
-                        doReadType = true;
-                    }
-                } catch (...) {
-                    // EOF reached
-                    return;
+                    currentVal = readPackedBits(reader, channel, bits, config);
+                }
+                planes.set(channel, seg.x + x, seg.y + y, currentVal);
+                currentCnt--;
+                if (currentCnt <= 0) {
+                    doReadType = true;
                 }
             }
         }
+        if (reader.overrun()) {
+            return;
+        }
     }
     reader.align();
 }
@@ -293,16 +414,52 @@ inline int32_t zigzagDecode(uint32_t n) {
     return static_cast<int32_t>((n >> 1) ^ -(static_cast<int32_t>(n) & 1));
 }
 
+void zigzagDecodeFields(uint32_t* fields, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        fields[i] = (fields[i] >> 1) ^ (0u - (fields[i] & 1));
+    }
+}
+
+// Running sum of the deltas from `start`, in place; returns the last value.
+// Chunks are scanned in log steps so only the carry is sequential.
+constexpr size_t SCAN_LANES = 8;
+
+uint32_t prefixSumFields(uint32_t* fields, size_t count, uint32_t start) {
+    uint32_t carry = start;
+    size_t i = 0;
+    for (; i + SCAN_LANES <= count; i += SCAN_LANES) {
+        uint32_t t[SCAN_LANES];
+        std::copy(fields + i, fields + i + SCAN_LANES, t);
+        for (size_t step = 1; step < SCAN_LANES; step *= 2) {
+            uint32_t s[SCAN_LANES];
+            for (size_t k = 0; k < SCAN_LANES; k++) {
+                s[k] = k >= step ? t[k] + t[k - step] : t[k];
+            }
+            std::copy(s, s + SCAN_LANES, t);
+        }
+        for (size_t k = 0; k < SCAN_LANES; k++) {
+            fields[i + k] = t[k] + carry;
+        }
+        carry = fields[i + SCAN_LANES - 1];
+    }
+    for (; i < count; i++) {
+        carry += fields[i];
+        fields[i] = carry;
+    }
+    return carry;
+}
+
 } // anonymous namespace
 
+template <typename Sink>
 void encodeDelta(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
     int prevVal = 0;
 
     for (const auto& seg : segments) {
@@ -326,35 +483,32 @@ void decodeDelta(
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
-    int prevVal = 0;
+    int bits = packedBits(config);
+    uint32_t prevVal = 0;
+    std::vector<uint32_t> fields;
 
     for (const auto& seg : segments) {
-        for (int x = 0; x < seg.size; x++) {
-            for (int y = 0; y < seg.size; y++) {
-                try {
-                    uint32_t encoded = static_cast<uint32_t>(reader.readInt(false, bits + 2));
-                    int delta = zigzagDecode(encoded);
-                    int val = prevVal + delta;
-                    planes.set(channel, seg.x + x, seg.y + y, val);
-                    prevVal = val;
-                } catch (...) {
-                    return;
-                }
-            }
+        fields.resize(static_cast<size_t>(seg.size) * seg.size);
+        reader.readFields(fields.data(), fields.size(), bits + 2);
+        zigzagDecodeFields(fields.data(), fields.size());
+        prevVal = prefixSumFields(fields.data(), fields.size(), prevVal);
+        planes.setBlock(channel, seg, reinterpret_cast<const int32_t*>(fields.data()));
+        if (reader.overrun()) {
+            return;
         }
     }
     reader.align();
 }
 
+template <typename Sink>
 void encodeXOR(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
     int prevVal = 0;
 
     for (const auto& seg : segments) {
@@ -377,34 +531,34 @@ void decodeXOR(
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
     int prevVal = 0;
 
     for (const auto& seg : segments) {
         for (int x = 0; x < seg.size; x++) {
             for (int y = 0; y < seg.size; y++) {
-                try {
-                    int xorVal = readPackedBits(reader, channel, bits, config);
-                    int val = xorVal ^ prevVal;
-                    planes.set(channel, seg.x + x, seg.y + y, val);
-                    prevVal = val;
-                } catch (...) {
-                    return;
-                }
+                int xorVal = readPackedBits(reader, channel, bits, config);
+                int val = xorVal ^ prevVal;
+                planes.set(channel, seg.x + x, seg.y + y, val);
+                prevVal = val;
             }
         }
+        if (reader.overrun()) {
+            return;
+        }
     }
     reader.align();
 }
 
+template <typename Sink>
 void encodeZigzag(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
 
     for (const auto& seg : segments) {
         for (int x = 0; x < seg.size; x++) {
@@ -425,22 +579,978 @@ void decodeZigzag(
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 ) {
-    int bits = calcBits(config.transformScale);
+    int bits = packedBits(config);
+    std::vector<uint32_t> fields;
+
+    for (const auto& seg : segments) {
+        fields.resize(static_cast<size_t>(seg.size) * seg.size);
+        reader.readFields(fields.data(), fields.size(), bits + 1);
+        zigzagDecodeFields(fields.data(), fields.size());
+        planes.setBlock(channel, seg, reinterpret_cast<const int32_t*>(fields.data()));
+        if (reader.overrun()) {
+            return;
+        }
+    }
+    reader.align();
+}
+
+// ============================================================================
+// Entropy-Coded Methods
+// ============================================================================
+
+namespace {
+
+// Wider fields code their low symbols directly and escape the rest
+constexpr int MAX_SYMBOL_BITS = 12;
+constexpr uint32_t ESCAPE_SYMBOL = (1u << MAX_SYMBOL_BITS) - 1;
+
+// Symbol for a value as PACKED would store it: the truncated field,
+// zigzagged when signed so small magnitudes map to small symbols
+uint32_t fieldSymbol(int val, PackedField field) {
+    uint32_t mask = field.width >= 32 ? ~0u : (1u << field.width) - 1;
+    uint32_t u = static_cast<uint32_t>(val) & mask;
+    if (!field.isSigned) {
+        return u;
+    }
+    if (field.width < 32 && (u >> (field.width - 1)) & 1) {
+        u |= ~mask;
+    }
+    return zigzagEncode(static_cast<int32_t>(u));
+}
+
+int fieldValue(uint32_t symbol, PackedField field) {
+    return field.isSigned ? zigzagDecode(symbol) : static_cast<int>(symbol);
+}
+
+// Values per rANS block; blocks are coded independently
+constexpr size_t RANS_CHUNK = 1 << 16;
+
+// Position of a value in coding order: segment, then x, then y
+struct SampleCursor {
+    size_t seg = 0;
+    int x = 0;
+    int y = 0;
+
+    bool operator==(const SampleCursor& other) const {
+        return seg == other.seg && x == other.x && y == other.y;
+    }
+
+    void next(const std::vector<Segment>& segments) {
+        int n = segments[seg].size;
+        if (++y < n) return;
+        y = 0;
+        if (++x < n) return;
+        x = 0;
+        seg++;
+    }
+
+    void prev(const std::vector<Segment>& segments) {
+        if (y > 0) {
+            y--;
+        } else if (x > 0) {
+            x--;
+            y = segments[seg].size - 1;
+        } else {
+            seg--;
+            x = y = segments[seg].size - 1;
+        }
+    }
+};
+
+} // anonymous namespace
+
+template <typename Sink>
+void encodeRANS(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    bool escapes = field.width > MAX_SYMBOL_BITS;
+    auto valueAt = [&](const SampleCursor& c) {
+        const Segment& seg = segments[c.seg];
+        return fieldSymbol(planes.get(channel, seg.x + c.x, seg.y + c.y), field);
+    };
+
+    std::vector<uint32_t> counts;
+    for (const auto& seg : segments) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                uint32_t v = fieldSymbol(planes.get(channel, seg.x + x, seg.y + y), field);
+                uint32_t s = escapes ? std::min(v, ESCAPE_SYMBOL) : v;
+                if (s >= counts.size()) {
+                    counts.resize(s + 1, 0);
+                }
+                counts[s]++;
+            }
+        }
+    }
+
+    // Frequency table: symbol count, then each frequency as a 5-bit length
+    // followed by that many bits
+    RansTable table = RansTable::fromCounts(counts);
+    writer.writeBits(static_cast<uint32_t>(table.symbolCount()), 16);
+    for (uint32_t f : table.frequencies()) {
+        int len = 0;
+        while (len < 32 && (f >> len) != 0) len++;
+        writer.writeBits(static_cast<uint32_t>(len), 5);
+        writer.writeBits(f, len);
+    }
+    writer.align();
+
+    // Blocks of RANS_CHUNK values: the payload size, the payload, then the
+    // block's escaped values in sample order. rANS codes back to front, so
+    // a block's payload is buffered, but never more than one, and costing
+    // only counts its bytes.
+    size_t total = sampleCount(segments);
+    std::vector<uint8_t> payload;
+    SampleCursor begin;
+    for (size_t done = 0; done < total;) {
+        size_t count = std::min(RANS_CHUNK, total - done);
+        SampleCursor end = begin;
+        for (size_t i = 0; i < count; i++) {
+            end.next(segments);
+        }
+
+        auto codeBlock = [&](auto&& emit) {
+            RansEncoder encoder;
+            SampleCursor c = end;
+            for (size_t i = count; i-- > 0;) {
+                c.prev(segments);
+                uint32_t v = valueAt(c);
+                encoder.put(i, escapes ? std::min(v, ESCAPE_SYMBOL) : v, table, emit);
+            }
+            encoder.finish(emit);
+        };
+        if constexpr (std::is_same_v<Sink, BitCounter>) {
+            // Costing only needs the payload size
+            size_t bytes = 0;
+            codeBlock([&](uint8_t) { bytes++; });
+            writer.writeBits(0, 32);
+            writer.writeBytes(nullptr, bytes);
+        } else {
+            payload.clear();
+            codeBlock([&](uint8_t byte) { payload.push_back(byte); });
+            std::reverse(payload.begin(), payload.end());
+            writer.writeBits(static_cast<uint32_t>(payload.size()), 32);
+            writer.writeBytes(payload.data(), payload.size());
+        }
+
+        if (escapes) {
+            for (SampleCursor c = begin; !(c == end); c.next(segments)) {
+                uint32_t v = valueAt(c);
+                if (v >= ESCAPE_SYMBOL) {
+                    writer.writeBits(v, field.width);
+                }
+            }
+        }
+        writer.align();
+
+        begin = end;
+        done += count;
+    }
+}
+
+void decodeRANS(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    bool escapes = field.width > MAX_SYMBOL_BITS;
+
+    std::vector<uint32_t> freqs(reader.readBits(16));
+    for (auto& f : freqs) {
+        f = reader.readBits(static_cast<int>(reader.readBits(5)));
+    }
+
+    RansTable table;
+    if (reader.overrun() || !table.setFrequencies(freqs)) {
+        return;
+    }
+
+    std::vector<uint8_t> payload;
+    std::vector<uint32_t> symbols;
+    size_t remaining = sampleCount(segments);
+    size_t k = 0;
+    for (const auto& seg : segments) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                if (k == symbols.size()) {
+                    // Next block
+                    reader.align();
+                    size_t payloadSize = std::min<size_t>(reader.readBits(32), reader.bytesRemaining());
+                    payload.resize(payloadSize);
+                    reader.readBytes(payload.data(), payloadSize);
+                    symbols.resize(std::min(RANS_CHUNK, remaining));
+                    remaining -= symbols.size();
+                    ransDecode(payload.data(), payloadSize, symbols.size(), table, symbols.data());
+                    k = 0;
+                }
+                uint32_t s = symbols[k++];
+                if (escapes && s == ESCAPE_SYMBOL) {
+                    s = reader.readBits(field.width);
+                }
+                planes.set(channel, seg.x + x, seg.y + y, fieldValue(s, field));
+            }
+        }
+        if (reader.overrun()) {
+            return;
+        }
+    }
+    reader.align();
+}
+
+namespace {
+
+// Rice contexts, indexed by the bit length of neighbouring activity
+constexpr int RICE_CONTEXTS = 12;
+// Statistics are halved when a context has seen this many values
+constexpr uint32_t RICE_RESET = 64;
+// Quotients from this length on are escaped to the raw field
+constexpr int RICE_ESCAPE = 24;
+
+// Fields are treated as two's complement of their width, so unsigned
+// fields holding wrapped negatives still map to small magnitudes
+int32_t wrappedInt(int val, PackedField field) {
+    uint32_t mask = field.width >= 32 ? ~0u : (1u << field.width) - 1;
+    uint32_t u = static_cast<uint32_t>(val) & mask;
+    if (field.width < 32 && (u >> (field.width - 1)) & 1) {
+        u |= ~mask;
+    }
+    return static_cast<int32_t>(u);
+}
+
+// The value PACKED reads back for a wrapped field
+int unwrappedValue(int32_t v, PackedField field) {
+    if (field.isSigned || field.width >= 32) {
+        return v;
+    }
+    return static_cast<int>(static_cast<uint32_t>(v) & ((1u << field.width) - 1));
+}
+
+uint32_t wrappedSymbol(int val, PackedField field) {
+    return zigzagEncode(wrappedInt(val, field));
+}
+
+int wrappedValue(uint32_t symbol, PackedField field) {
+    return unwrappedValue(zigzagDecode(symbol), field);
+}
+
+// JPEG-LS style running statistics: the Rice parameter is the smallest k
+// with count << k >= accumulated magnitude
+class RiceModel {
+public:
+    RiceModel() {
+        for (auto& c : contexts_) {
+            c.sum = 4;
+            c.count = 1;
+        }
+    }
+
+    static int context(uint32_t left, uint32_t above) {
+        uint64_t activity = uint64_t(left) + above;
+        int len = 0;
+        while (activity >> len) len++;
+        return std::min(len, RICE_CONTEXTS - 1);
+    }
+
+    int parameter(int ctx) const {
+        const Context& c = contexts_[ctx];
+        int k = 0;
+        while (k < 31 && (uint64_t(c.count) << k) < c.sum) k++;
+        return k;
+    }
+
+    void update(int ctx, uint32_t symbol) {
+        Context& c = contexts_[ctx];
+        c.sum += symbol;
+        if (++c.count == RICE_RESET) {
+            c.sum >>= 1;
+            c.count >>= 1;
+        }
+    }
+
+private:
+    struct Context {
+        uint64_t sum;
+        uint32_t count;
+    };
+    Context contexts_[RICE_CONTEXTS];
+};
+
+} // anonymous namespace
+
+template <typename Sink>
+void encodeRice(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    RiceModel model;
+    std::vector<uint32_t> line;
+
+    for (const auto& seg : segments) {
+        // line holds the previous line's symbols, overwritten as we go
+        line.assign(seg.size, 0);
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                uint32_t z = wrappedSymbol(planes.get(channel, seg.x + x, seg.y + y), field);
+                int ctx = RiceModel::context(y > 0 ? line[y - 1] : 0, line[y]);
+                int k = model.parameter(ctx);
+
+                uint32_t q = z >> k;
+                if (q < RICE_ESCAPE) {
+                    // q zeros and a terminating one
+                    writer.writeBits(1, static_cast<int>(q) + 1);
+                    writer.writeBits(z, k);
+                } else {
+                    writer.writeBits(0, RICE_ESCAPE);
+                    writer.writeBits(z, field.width);
+                }
+
+                model.update(ctx, z);
+                line[y] = z;
+            }
+        }
+    }
+    writer.align();
+}
+
+void decodeRice(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    RiceModel model;
+    std::vector<uint32_t> line;
 
     for (const auto& seg : segments) {
+        line.assign(seg.size, 0);
         for (int x = 0; x < seg.size; x++) {
             for (int y = 0; y < seg.size; y++) {
-                try {
-                    uint32_t encoded = static_cast<uint32_t>(reader.readInt(false, bits + 1));
-                    int val = zigzagDecode(encoded);
-                    planes.set(channel, seg.x + x, seg.y + y, val);
-                } catch (...) {
-                    return;
+                int ctx = RiceModel::context(y > 0 ? line[y - 1] : 0, line[y]);
+                int k = model.parameter(ctx);
+
+                uint32_t z;
+                int q = reader.readUnary(RICE_ESCAPE);
+                if (q < RICE_ESCAPE) {
+                    z = (static_cast<uint32_t>(q) << k) | reader.readBits(k);
+                } else {
+                    z = reader.readBits(field.width);
                 }
+
+                model.update(ctx, z);
+                line[y] = z;
+                planes.set(channel, seg.x + x, seg.y + y, wrappedValue(z, field));
             }
         }
+        if (reader.overrun()) {
+            return;
+        }
     }
     reader.align();
 }
 
+namespace {
+
+// Huffman symbols: values below HUFFMAN_DIRECT code as themselves, larger
+// ones as their bit-length class c (value in [2^c, 2^(c+1))) followed by c
+// raw bits. 37 symbols cover 32-bit values and fit the channel header.
+constexpr uint32_t HUFFMAN_DIRECT = 8;
+constexpr int HUFFMAN_FIRST_CLASS = 3;
+
+uint32_t huffmanSymbol(uint32_t z, int& extraBits) {
+    if (z < HUFFMAN_DIRECT) {
+        extraBits = 0;
+        return z;
+    }
+    int c = 31;
+    while (!((z >> c) & 1)) c--;
+    extraBits = c;
+    return HUFFMAN_DIRECT + (c - HUFFMAN_FIRST_CLASS);
+}
+
+uint32_t huffmanValue(uint32_t symbol, BitReader& reader) {
+    if (symbol < HUFFMAN_DIRECT) {
+        return symbol;
+    }
+    int c = static_cast<int>(symbol - HUFFMAN_DIRECT) + HUFFMAN_FIRST_CLASS;
+    return (1u << c) | reader.readBits(c);
+}
+
+// Raw bits following a symbol's code
+int huffmanExtraBits(uint32_t symbol) {
+    return symbol < HUFFMAN_DIRECT ? 0 : static_cast<int>(symbol - HUFFMAN_DIRECT) + HUFFMAN_FIRST_CLASS;
+}
+
+// Symbol counts of a channel, without trailing unused symbols
+std::vector<uint32_t> huffmanCounts(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    std::vector<uint32_t> counts(HUFFMAN_SYMBOLS, 0);
+    for (const auto& seg : segments) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                int extra;
+                counts[huffmanSymbol(wrappedSymbol(planes.get(channel, seg.x + x, seg.y + y), field), extra)]++;
+            }
+        }
+    }
+    while (!counts.empty() && counts.back() == 0) {
+        counts.pop_back();
+    }
+    return counts;
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> huffmanCodeLengths(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    // Trailing unused symbols are not stored
+    return huffmanLengths(huffmanCounts(planes, channel, segments, config));
+}
+
+template <typename Sink>
+void encodeHuffman(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    if constexpr (std::is_same_v<Sink, BitCounter>) {
+        // Costing: the size follows from the symbol counts and code lengths
+        std::vector<uint32_t> counts = huffmanCounts(planes, channel, segments, config);
+        std::vector<uint8_t> lengths = config.codeLengths.empty() ? huffmanLengths(counts) : config.codeLengths;
+        for (size_t s = 0; s < counts.size() && s < lengths.size(); s++) {
+            writer.addBits(uint64_t(counts[s]) * (lengths[s] + huffmanExtraBits(static_cast<uint32_t>(s))));
+        }
+        writer.align();
+        return;
+    }
+    PackedField field = packedField(packedBits(config), config);
+    std::vector<uint8_t> lengths = config.codeLengths.empty()
+        ? huffmanCodeLengths(planes, channel, segments, config)
+        : config.codeLengths;
+    HuffmanCode code;
+    code.build(lengths, HUFFMAN_DIRECT);
+
+    for (const auto& seg : segments) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                uint32_t z = wrappedSymbol(planes.get(channel, seg.x + x, seg.y + y), field);
+                int extra;
+                uint32_t s = huffmanSymbol(z, extra);
+                writer.writeBits(code.code(s), code.length(s));
+                writer.writeBits(z, extra);
+            }
+        }
+    }
+    writer.align();
+}
+
+void decodeHuffman(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    HuffmanCode code;
+    if (config.codeLengths.empty() || !code.build(config.codeLengths, HUFFMAN_DIRECT)) {
+        return;
+    }
+
+    // Decode the channel's symbols up front, several per table probe
+    std::vector<uint32_t> values(sampleCount(segments));
+    size_t i = 0;
+    while (i < values.size() && !reader.overrun()) {
+        reader.refill();
+        const HuffmanCode::Entry& e = code.lookup(reader.peek(HUFFMAN_TABLE_BITS));
+        if (e.count == 0 || reader.buffered() < e.length) {
+            // Long code, or too close to the end for a full probe
+            int s = code.decodeSlow(reader);
+            if (s < 0) break;
+            values[i++] = huffmanValue(static_cast<uint32_t>(s), reader);
+            continue;
+        }
+        reader.consume(e.length);
+        for (int k = 0; k < e.count && i < values.size(); k++) {
+            values[i++] = huffmanValue(e.symbols[k], reader);
+        }
+    }
+
+    i = 0;
+    for (const auto& seg : segments) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                planes.set(channel, seg.x + x, seg.y + y, wrappedValue(values[i++], field));
+            }
+        }
+        if (reader.overrun()) {
+            return;
+        }
+    }
+    reader.align();
+}
+
+namespace {
+
+// Bits in a BLOCKPACK segment header's width field
+constexpr int BLOCK_WIDTH_BITS = 6;
+
+int bitLength(uint64_t v) {
+    int len = 0;
+    while (v >> len) len++;
+    return len;
+}
+
+} // anonymous namespace
+
+template <typename Sink>
+void encodeBlockPacked(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    std::vector<int32_t> values;
+
+    for (const auto& seg : segments) {
+        values.clear();
+        int32_t lo = std::numeric_limits<int32_t>::max();
+        int32_t hi = std::numeric_limits<int32_t>::min();
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                int32_t v = wrappedInt(planes.get(channel, seg.x + x, seg.y + y), field);
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+                values.push_back(v);
+            }
+        }
+
+        // Segment header: the minimum as a stored field, then the width of
+        // the offsets from it
+        int width = bitLength(static_cast<uint64_t>(int64_t(hi) - lo));
+        writer.writeBits(static_cast<uint32_t>(lo), field.width);
+        writer.writeBits(static_cast<uint32_t>(width), BLOCK_WIDTH_BITS);
+        for (int32_t v : values) {
+            writer.writeBits(static_cast<uint32_t>(int64_t(v) - lo), width);
+        }
+    }
+    writer.align();
+}
+
+void decodeBlockPacked(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    std::vector<uint32_t> offsets;
+
+    for (const auto& seg : segments) {
+        int32_t lo = wrappedInt(static_cast<int>(reader.readBits(field.width)), field);
+        int width = std::min<int>(reader.readBits(BLOCK_WIDTH_BITS), 32);
+
+        offsets.resize(static_cast<size_t>(seg.size) * seg.size);
+        reader.readFields(offsets.data(), offsets.size(), width);
+
+        const uint32_t* offset = offsets.data();
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                int32_t v = static_cast<int32_t>(static_cast<uint32_t>(lo) + *offset++);
+                planes.set(channel, seg.x + x, seg.y + y, unwrappedValue(v, field));
+            }
+        }
+        if (reader.overrun()) {
+            return;
+        }
+    }
+    reader.align();
+}
+
+// ============================================================================
+// Significance Map
+// ============================================================================
+
+namespace {
+
+// Subband scales with their own models; finer scales share the last
+constexpr int SIG_SCALES = 12;
+// Bit lengths of a significant magnitude (1-32)
+constexpr int SIG_MAG_CLASSES = 33;
+
+// Context models of one channel's significance map coder
+struct SigModels {
+    BitModel band[SIG_SCALES][3];         // subband has any nonzero value
+    BitModel significant[SIG_SCALES][3];  // by count of significant neighbours
+    BitModel sign;
+    BitModel magClass[3][SIG_MAG_CLASSES];
+    BitModel mantissa[32];
+};
+
+// Dyadic subbands of an n x n block: scale 0 is the DC coefficient, scale
+// s >= 1 has three orientations covering [h, 2h) in x, in y and in both,
+// with h = 2^(s-1). Calls f(x0, y0, size, scale, orientation).
+template <typename F>
+void forEachSubband(int n, F&& f) {
+    f(0, 0, 1, 0, 0);
+    int scale = 1;
+    for (int h = 1; h < n; h *= 2, scale++) {
+        f(h, 0, h, scale, 0);
+        f(0, h, h, scale, 1);
+        f(h, h, h, scale, 2);
+    }
+}
+
+inline int sigScale(int scale) {
+    return std::min(scale, SIG_SCALES - 1);
+}
+
+// Magnitude models are shared by coarse, middle and fine scales
+inline int magGroup(int scale) {
+    return scale < 2 ? 0 : scale < 4 ? 1 : 2;
+}
+
+// Significant neighbours (left and above) decoded before (x, y) in its band
+inline int sigNeighbours(const int32_t* block, int n, int x, int y, int x0, int y0) {
+    return (x > x0 && block[(x - 1) * n + y] != 0) + (y > y0 && block[x * n + y - 1] != 0);
+}
+
+template <typename Sink>
+void encodeSignificant(BinaryEncoder<Sink>& coder, SigModels& models, int32_t v, int scale) {
+    coder.encode(models.sign, v < 0);
+    uint32_t mag = v < 0 ? 0u - static_cast<uint32_t>(v) : static_cast<uint32_t>(v);
+    int cls = bitLength(mag);
+    auto& classes = models.magClass[magGroup(scale)];
+    for (int c = 1; c < cls; c++) {
+        coder.encode(classes[c], true);
+    }
+    if (cls < 32) {
+        coder.encode(classes[cls], false);
+    }
+    for (int b = cls - 2; b >= 0; b--) {
+        coder.encode(models.mantissa[b], (mag >> b) & 1);
+    }
+}
+
+int32_t decodeSignificant(BinaryDecoder& coder, SigModels& models, int scale) {
+    bool negative = coder.decode(models.sign);
+    auto& classes = models.magClass[magGroup(scale)];
+    int cls = 1;
+    while (cls < 32 && coder.decode(classes[cls])) {
+        cls++;
+    }
+    uint32_t mag = 1;
+    for (int b = cls - 2; b >= 0; b--) {
+        mag = (mag << 1) | (coder.decode(models.mantissa[b]) ? 1 : 0);
+    }
+    return static_cast<int32_t>(negative ? 0u - mag : mag);
+}
+
+} // anonymous namespace
+
+template <typename Sink>
+void encodeSigMap(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    auto models = std::make_unique<SigModels>();
+    // Range-coded bytes go straight to the writer, which starts aligned
+    writer.align();
+    BinaryEncoder<Sink> coder(writer);
+    std::vector<int32_t> block;
+
+    for (const auto& seg : segments) {
+        int n = seg.size;
+        block.resize(static_cast<size_t>(n) * n);
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                block[x * n + y] = wrappedInt(planes.get(channel, seg.x + x, seg.y + y), field);
+            }
+        }
+
+        forEachSubband(n, [&](int x0, int y0, int size, int scale, int orientation) {
+            bool any = false;
+            for (int x = x0; x < x0 + size && !any; x++) {
+                for (int y = y0; y < y0 + size; y++) {
+                    if (block[x * n + y] != 0) {
+                        any = true;
+                        break;
+                    }
+                }
+            }
+            coder.encode(models->band[sigScale(scale)][orientation], any);
+            if (!any) return;
+
+            for (int x = x0; x < x0 + size; x++) {
+                for (int y = y0; y < y0 + size; y++) {
+                    int32_t v = block[x * n + y];
+                    int ctx = sigNeighbours(block.data(), n, x, y, x0, y0);
+                    coder.encode(models->significant[sigScale(scale)][ctx], v != 0);
+                    if (v != 0) {
+                        encodeSignificant(coder, *models, v, scale);
+                    }
+                }
+            }
+        });
+    }
+    coder.finish();
+    writer.align();
+}
+
+void decodeSigMap(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    auto models = std::make_unique<SigModels>();
+    BinaryDecoder coder(reader);
+    std::vector<int32_t> block;
+
+    for (const auto& seg : segments) {
+        int n = seg.size;
+        // Insignificant bands and coefficients stay zero
+        block.assign(static_cast<size_t>(n) * n, 0);
+
+        forEachSubband(n, [&](int x0, int y0, int size, int scale, int orientation) {
+            if (!coder.decode(models->band[sigScale(scale)][orientation])) return;
+
+            for (int x = x0; x < x0 + size; x++) {
+                for (int y = y0; y < y0 + size; y++) {
+                    int ctx = sigNeighbours(block.data(), n, x, y, x0, y0);
+                    if (coder.decode(models->significant[sigScale(scale)][ctx])) {
+                        block[x * n + y] = unwrappedValue(decodeSignificant(coder, *models, scale), field);
+                    }
+                }
+            }
+        });
+
+        planes.setBlock(channel, seg, block.data());
+        if (reader.overrun()) {
+            return;
+        }
+    }
+    reader.align();
+}
+
+// ============================================================================
+// Bit-Plane Layers
+// ============================================================================
+
+namespace {
+
+// Context models of one channel's bit-plane coder, kept across layers
+struct PlaneModels {
+    BitModel significant[3][3];  // by scale group and significant neighbours
+    BitModel sign;
+    BitModel refine[2];          // first refinement of a value, later ones
+};
+
+// Bit-plane state of a value
+enum PlaneState : uint8_t {
+    INSIGNIFICANT = 0,
+    NEWLY_SIGNIFICANT = 1,
+    REFINED = 2
+};
+
+// Calls f(index, segment size, x, y) for every value in coding order
+template <typename F>
+void forEachPosition(const std::vector<Segment>& segments, F&& f) {
+    size_t i = 0;
+    for (const auto& seg : segments) {
+        int n = seg.size;
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                f(i++, n, x, y);
+            }
+        }
+    }
+}
+
+// Layer 0 holds every plane down to layers - 1, each later layer one plane
+inline int layerLowPlane(int layer, int layers) {
+    return layers - 1 - layer;
+}
+
+// Walks one bit-plane for the encoder or the decoder: bit(i, model,
+// significance) codes a value's bit with the model and returns it.
+// Significance uses the left and upper neighbours in the segment.
+template <typename Bit>
+void codePlane(
+    PlaneModels& models,
+    const std::vector<Segment>& segments,
+    std::vector<uint8_t>& state,
+    Bit&& bit
+) {
+    forEachPosition(segments, [&](size_t i, int n, int x, int y) {
+        if (state[i] == INSIGNIFICANT) {
+            int ctx = (x > 0 && state[i - n] != INSIGNIFICANT) + (y > 0 && state[i - 1] != INSIGNIFICANT);
+            int group = magGroup(bitLength(static_cast<uint64_t>(std::max(x, y))));
+            if (bit(i, models.significant[group][ctx], true)) {
+                state[i] = NEWLY_SIGNIFICANT;
+            }
+        } else {
+            bit(i, models.refine[state[i] - 1], false);
+            state[i] = REFINED;
+        }
+    });
+}
+
+} // anonymous namespace
+
+ChannelLayers encodeLayers(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    std::vector<uint32_t> mags;
+    std::vector<uint8_t> negative;
+    uint32_t maxMag = 0;
+    for (const auto& seg : segments) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                int32_t v = wrappedInt(planes.get(channel, seg.x + x, seg.y + y), field);
+                uint32_t mag = v < 0 ? 0u - static_cast<uint32_t>(v) : static_cast<uint32_t>(v);
+                mags.push_back(mag);
+                negative.push_back(v < 0);
+                maxMag = std::max(maxMag, mag);
+            }
+        }
+    }
+
+    ChannelLayers result;
+    result.planes = bitLength(maxMag);
+    int layers = std::min(result.planes, MAX_LAYERS);
+
+    PlaneModels models;
+    std::vector<uint8_t> state(mags.size(), INSIGNIFICANT);
+    int plane = result.planes - 1;
+    for (int layer = 0; layer < layers; layer++) {
+        BitWriter writer;
+        BinaryEncoder coder(writer);
+        for (; plane >= layerLowPlane(layer, layers); plane--) {
+            codePlane(models, segments, state, [&](size_t i, BitModel& model, bool significance) {
+                bool bit = (mags[i] >> plane) & 1;
+                coder.encode(model, bit);
+                if (significance && bit) {
+                    coder.encode(models.sign, negative[i]);
+                }
+                return bit;
+            });
+        }
+        coder.finish();
+        result.layers.push_back(writer.data());
+    }
+    return result;
+}
+
+void decodeLayers(
+    const std::vector<LayerSpan>& layers,
+    int bitPlanes,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+) {
+    PackedField field = packedField(packedBits(config), config);
+    size_t count = 0;
+    for (const auto& seg : segments) {
+        count += static_cast<size_t>(seg.size) * seg.size;
+    }
+
+    std::vector<uint32_t> mags(count, 0);
+    std::vector<uint8_t> negative(count, 0);
+    std::vector<uint8_t> state(count, INSIGNIFICANT);
+    PlaneModels models;
+
+    int layerCount = std::min(bitPlanes, MAX_LAYERS);
+    int plane = bitPlanes - 1;
+    for (int layer = 0; layer < layerCount && layer < static_cast<int>(layers.size()); layer++) {
+        BitReader reader(layers[layer].data, layers[layer].size);
+        BinaryDecoder coder(reader);
+        for (; plane >= layerLowPlane(layer, layerCount); plane--) {
+            codePlane(models, segments, state, [&](size_t i, BitModel& model, bool significance) {
+                bool bit = coder.decode(model);
+                mags[i] |= static_cast<uint32_t>(bit) << plane;
+                if (significance && bit) {
+                    negative[i] = coder.decode(models.sign);
+                }
+                return bit;
+            });
+        }
+    }
+
+    // Planes below `plane` are unknown when layers are missing. The midpoint
+    // must not carry a magnitude past the field, which would flip its sign.
+    uint32_t midpoint = plane >= 0 ? 1u << plane : 0;
+    uint32_t top = 1u << (std::min(field.width, 32) - 1);
+    std::vector<int32_t> block;
+    size_t i = 0;
+    for (const auto& seg : segments) {
+        block.resize(static_cast<size_t>(seg.size) * seg.size);
+        for (auto& v : block) {
+            uint32_t mag = mags[i] != 0 ? mags[i] | midpoint : 0;
+            mag = std::min(mag, negative[i] ? top : top - 1);
+            v = unwrappedValue(static_cast<int32_t>(negative[i] ? 0u - mag : mag), field);
+            i++;
+        }
+        planes.setBlock(channel, seg, block.data());
+    }
+}
+
+// Encoders are built for real output and for bit counting
+#define GLIC_INSTANTIATE_ENCODERS(Sink) \
+    template void encodeData<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, EncodingMethod, const ChannelConfig&); \
+    template void encodeRaw<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&); \
+    template void encodePacked<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeRLE<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeDelta<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeXOR<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeZigzag<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeRANS<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeRice<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeHuffman<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeBlockPacked<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&); \
+    template void encodeSigMap<Sink>(Sink&, const Planes&, int, const std::vector<Segment>&, const ChannelConfig&);
+
+GLIC_INSTANTIATE_ENCODERS(BitWriter)
+GLIC_INSTANTIATE_ENCODERS(BitCounter)
+
+#undef GLIC_INSTANTIATE_ENCODERS
+
 } // namespace glic
@@ -8,9 +8,12 @@
 
 namespace glic {
 
-// Encode data using specified method
+// Encode data using specified method. Sink is BitWriter for real output or
+// BitCounter to cost the encoding exactly without writing it; both are
+// instantiated in encoding.cpp.
+template <typename Sink>
 void encodeData(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
@@ -18,6 +21,15 @@ void encodeData(
     const ChannelConfig& config
 );
 
+// Cost every encoding method on the channel (in parallel, exact bit counts)
+// and return the one giving the smallest output
+EncodingMethod chooseEncoding(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
 // Decode data using specified method
 void decodeData(
     BitReader& reader,
@@ -29,23 +41,26 @@ void decodeData(
 );
 
 // Individual encoding methods
+template <typename Sink>
 void encodeRaw(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments
 );
 
+template <typename Sink>
 void encodePacked(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 );
 
+template <typename Sink>
 void encodeRLE(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
@@ -78,24 +93,27 @@ void decodeRLE(
 );
 
 // New encoding methods
+template <typename Sink>
 void encodeDelta(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 );
 
+template <typename Sink>
 void encodeXOR(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
     const ChannelConfig& config
 );
 
+template <typename Sink>
 void encodeZigzag(
-    BitWriter& writer,
+    Sink& writer,
     const Planes& planes,
     int channel,
     const std::vector<Segment>& segments,
@@ -126,4 +144,148 @@ void decodeZigzag(
     const ChannelConfig& config
 );
 
+// Entropy-coded methods. RANS codes the same stored values as PACKED
+// with a per-channel static frequency table and interleaved rANS states,
+// in independent blocks so the encoder holds one block at a time.
+template <typename Sink>
+void encodeRANS(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+void decodeRANS(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// RICE is adaptive Golomb-Rice over zigzagged values, with the parameter
+// chosen per context from neighbouring magnitudes; no tables
+template <typename Sink>
+void encodeRice(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+void decodeRice(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// Alphabet size of HUFFMAN; its code lengths fit the channel header
+constexpr size_t HUFFMAN_SYMBOLS = 37;
+
+// Per-channel canonical Huffman code lengths for HUFFMAN, stored by the
+// codec in the channel header (config.codeLengths)
+std::vector<uint8_t> huffmanCodeLengths(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// HUFFMAN codes zigzagged values with config.codeLengths, or with lengths
+// built from the data when none are given (for costing)
+template <typename Sink>
+void encodeHuffman(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+void decodeHuffman(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// BLOCKPACK is PACKED with a frame of reference per segment: the segment's
+// minimum and a bit width, then each value's offset in exactly that width
+template <typename Sink>
+void encodeBlockPacked(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+void decodeBlockPacked(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// SIGMAP codes each segment's dyadic subbands as a significance map: a
+// range-coded flag per subband, then per coefficient of nonzero subbands,
+// then only the nonzero values. Suits thresholded transform coefficients.
+template <typename Sink>
+void encodeSigMap(
+    Sink& writer,
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+void decodeSigMap(
+    BitReader& reader,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// Most quality layers a LAYERED channel is split into
+constexpr int MAX_LAYERS = 8;
+
+// A LAYERED channel: magnitude bit-planes of the stored values, most
+// significant first, range coded and grouped into quality layers. Each
+// layer refines the values decoded from the layers before it.
+struct ChannelLayers {
+    int planes = 0;
+    std::vector<std::vector<uint8_t>> layers;
+};
+
+// Span of one stored layer
+struct LayerSpan {
+    const uint8_t* data;
+    size_t size;
+};
+
+ChannelLayers encodeLayers(
+    const Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
+// Decode from the first layers of a channel with bitPlanes planes. With
+// layers missing, significant values sit mid-way through what is unknown.
+void decodeLayers(
+    const std::vector<LayerSpan>& layers,
+    int bitPlanes,
+    Planes& planes,
+    int channel,
+    const std::vector<Segment>& segments,
+    const ChannelConfig& config
+);
+
 } // namespace glic
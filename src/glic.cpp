@@ -3,10 +3,11 @@
 #include "planes.hpp"
 #include "segment.hpp"
 #include "prediction.hpp"
-#include "quantization.hpp"
-#include "wavelet.hpp"
+#include "pipeline.hpp"
 #include "encoding.hpp"
 #include "bitio.hpp"
+#include "mappedfile.hpp"
+#include "container.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -14,12 +15,277 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GLIC_HAVE_MKSTEMP 1
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 namespace glic {
 
+namespace {
+
+// 64-bit file positions; long is 32 bits on Windows
+#ifdef _MSC_VER
+int64_t tell(std::FILE* file) {
+    return _ftelli64(file);
+}
+
+int seek(std::FILE* file, int64_t offset) {
+    return _fseeki64(file, offset, SEEK_SET);
+}
+#else
+int64_t tell(std::FILE* file) {
+    return static_cast<int64_t>(ftello(file));
+}
+
+int seek(std::FILE* file, int64_t offset) {
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+}
+#endif
+
+// Creates a file with a unique name next to path and opens it for writing,
+// setting tempPath to its name. Returns null if no file could be created.
+std::FILE* createTempFile(const std::string& path, std::string& tempPath) {
+#ifdef GLIC_HAVE_MKSTEMP
+    std::string name = path + ".XXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        return nullptr;
+    }
+    // mkstemp makes the file private; give it the mode fopen would
+    mode_t mask = umask(0);
+    umask(mask);
+    fchmod(fd, 0666 & ~mask);
+
+    tempPath = name;
+    std::FILE* file = fdopen(fd, "wb");
+    if (!file) {
+        ::close(fd);
+        std::remove(tempPath.c_str());
+    }
+    return file;
+#else
+    // "x" fails on an existing file, so each name is claimed by one writer
+    for (int attempt = 0; attempt < 100; attempt++) {
+        tempPath = path + "." + std::to_string(attempt) + ".tmp";
+        if (std::FILE* file = std::fopen(tempPath.c_str(), "wbx")) {
+            return file;
+        }
+    }
+    return nullptr;
+#endif
+}
+
+// Moves tempPath over path in one step, replacing any existing file
+bool replaceFile(const std::string& tempPath, const std::string& path) {
+#ifdef _WIN32
+    return MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+}
+
+// Output file; header fields are patched in place once sizes are known
+class FileSink : public ByteSink {
+public:
+    explicit FileSink(std::FILE* file) : file_(file) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        if (size > 0 && std::fwrite(data, 1, size, file_) != size) {
+            throw std::runtime_error("Failed to write output file");
+        }
+    }
+
+    bool seekable() const override { return true; }
+
+    void patch(size_t offset, const uint8_t* data, size_t size) override {
+        int64_t end = tell(file_);
+        if (end < 0 || seek(file_, static_cast<int64_t>(offset)) != 0) {
+            throw std::runtime_error("Failed to seek output file");
+        }
+        write(data, size);
+        if (seek(file_, end) != 0) {
+            throw std::runtime_error("Failed to seek output file");
+        }
+    }
+
+private:
+    std::FILE* file_;
+};
+
+// Passes bytes through and counts them, to size a streamed section
+class CountingSink : public ByteSink {
+public:
+    explicit CountingSink(ByteSink& sink) : sink_(sink) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        sink_.write(data, size);
+        count_ += size;
+    }
+
+    size_t count() const { return count_; }
+
+private:
+    ByteSink& sink_;
+    size_t count_ = 0;
+};
+
+// Bytes of a section, or null if it is missing or runs past the end
+LayerSpan sectionSpan(const uint8_t* buffer, size_t size, const Section* section) {
+    if (!section || section->offset > size || size - section->offset < section->length) {
+        return {nullptr, 0};
+    }
+    return {buffer + section->offset, static_cast<size_t>(section->length)};
+}
+
+// Segments of a channel from its segmentation section
+std::vector<Segment> readSegments(const ContainerInfo& info, LayerSpan span) {
+    // Calculate padded dimensions
+    int ww = 1;
+    while (ww < info.width) ww *= 2;
+    int hh = 1;
+    while (hh < info.height) hh *= 2;
+
+    BitReader reader(span.data, span.size);
+    return readSegmentation(reader, ww, hh, info.width, info.height, info.version != 1);
+}
+
+// Decode one channel, reading only that channel's sections, and
+// reconstruct the segments the region depends on. With a reduced plane
+// set, reconstruct at 1/factor scale into it instead.
+bool decodeChannel(const uint8_t* buffer, size_t size, const ContainerInfo& info, int p,
+                   const PixelRect& region, Planes& planes, std::string& error,
+                   int factor = 1, Planes* reduced = nullptr) {
+    const auto& chConfig = info.channels[p];
+
+    LayerSpan segSpan = sectionSpan(buffer, size, info.find(SectionKind::SEGMENTATION, p));
+    LayerSpan predSpan = sectionSpan(buffer, size, info.find(SectionKind::PREDICTION, p));
+    if (!segSpan.data || !predSpan.data) {
+        error = "Truncated file";
+        return false;
+    }
+
+    // Read segmentation data and reconstruct segments
+    std::cout << "Channel " << p << " segmentation" << std::endl;
+    auto segments = readSegments(info, segSpan);
+
+    // Read prediction data
+    BitReader predReader(predSpan.data, predSpan.size);
+    if (info.version != 1) {
+        for (auto& seg : segments) {
+            seg.skip = predReader.readBoolean();
+        }
+        predReader.align();
+        readPredictionData(predReader, segments, chConfig.predictionMethod);
+    } else {
+        // Version 1: fixed 8-byte records
+        for (auto& seg : segments) {
+            auto predType = static_cast<PredictionMethod>(predReader.readByte());
+            int16_t refX = static_cast<int16_t>(predReader.readBits(16));
+            int16_t refY = static_cast<int16_t>(predReader.readBits(16));
+            int refAngle = predReader.readByte() % 3;
+            int16_t angleVal = static_cast<int16_t>(predReader.readBits(16));
+            if (predReader.overrun()) {
+                break;
+            }
+            seg.predType = predType == PredictionMethod::NONE ? chConfig.predictionMethod : predType;
+            seg.refX = refX;
+            seg.refY = refY;
+            seg.refAngle = refAngle;
+            seg.angle = static_cast<float>(angleVal) / 0x7000;
+        }
+    }
+
+    // Locate the data layers present. A truncated progressive stream
+    // decodes from the complete layers it still holds.
+    std::vector<LayerSpan> layers;
+    int layerCount = info.dataSections(p);
+    for (int l = 0; l < layerCount; l++) {
+        LayerSpan span = sectionSpan(buffer, size, info.find(SectionKind::DATA, p, l));
+        if (!span.data) {
+            if (!(info.flags & GLIC_FLAG_LAYERED)) {
+                error = "Truncated file";
+                return false;
+            }
+            break;
+        }
+        layers.push_back(span);
+    }
+
+    // Decode image data
+    auto coded = codedSegments(segments);
+    if (chConfig.encodingMethod == EncodingMethod::LAYERED) {
+        std::cout << "Layers for plane " << p << " -> " << layers.size() << " of " << layerCount << std::endl;
+        decodeLayers(layers, info.bitPlanes[p], planes, p, coded, chConfig);
+    } else if (!layers.empty()) {
+        BitReader dataReader(layers[0].data, layers[0].size);
+        decodeData(dataReader, planes, p, coded, chConfig.encodingMethod, chConfig);
+    }
+
+    // Reconstruct the channel
+    ChannelPipeline pipeline(chConfig, p);
+
+    std::cout << "Wavelet for plane " << p << " -> " << pipeline.transformName() << std::endl;
+    std::cout << "Prediction for plane " << p << " -> " << predictionName(chConfig.predictionMethod) << std::endl;
+
+    if (reduced) {
+        std::vector<int> coverage(static_cast<size_t>(reduced->width()) * reduced->height(), 0);
+        for (const auto& seg : segments) {
+            pipeline.reconstructReduced(planes, *reduced, seg, factor, coverage);
+        }
+        return true;
+    }
+
+    // Coded data is sequential, so all of it is decoded above; outside
+    // the region only the segments its predictions read are reconstructed
+    bool whole = region.x == 0 && region.y == 0 && region.w == info.width && region.h == info.height;
+    if (whole) {
+        // Inverse wavelet transform
+        pipeline.reverseTransform(planes, segments);
+
+        // Inverse quantization and predictions
+        for (auto& seg : segments) {
+            pipeline.reconstructSegment(planes, seg);
+        }
+        return true;
+    }
+
+    auto needs = regionDependencies(segments, region, info.width, info.height);
+    std::vector<Segment> transformed;
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (needs[i] != RegionNeed::NONE) {
+            transformed.push_back(segments[i]);
+        }
+    }
+    std::cout << "Reconstructing " << std::count(needs.begin(), needs.end(), RegionNeed::RECONSTRUCT)
+              << " of " << segments.size() << " segments" << std::endl;
+
+    pipeline.reverseTransform(planes, transformed);
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (needs[i] == RegionNeed::RECONSTRUCT) {
+            pipeline.reconstructSegment(planes, segments[i]);
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
 GlicCodec::GlicCodec() : config_() {}
 
 GlicCodec::GlicCodec(const CodecConfig& config) : config_(config) {}
@@ -32,8 +298,16 @@ void GlicCodec::setPostEffects(const PostEffectsConfig& effects) {
     postEffects_ = effects;
 }
 
-std::vector<uint8_t> GlicCodec::encodeToBuffer(const Color* pixels, int width, int height) {
-    std::vector<uint8_t> buffer;
+void GlicCodec::setDecodeOptions(const DecodeOptions& options) {
+    decodeOptions_ = options;
+}
+
+bool GlicCodec::encodeToSink(const Color* pixels, int width, int height, ByteSink& sink) {
+    // Decoders would reject the file
+    if (!validDimensions(width, height)) {
+        std::cerr << "Encoding failed: image dimensions out of range" << std::endl;
+        return false;
+    }
 
     try {
         std::cout << "Encoding started" << std::endl;
@@ -43,11 +317,19 @@ std::vector<uint8_t> GlicCodec::encodeToBuffer(const Color* pixels, int width, i
         RefColor ref(makeColor(config_.borderColorR, config_.borderColorG, config_.borderColorB), config_.colorSpace);
         Planes planes(pixels, width, height, config_.colorSpace, ref);
 
-        // Arrays to store segmentation and data for each channel
+        // Coded values of all channels; each channel only writes its own
+        auto resultPlanes = planes.clone();
+
+        // Side sections are kept until the header is written; image data
+        // is streamed to the sink afterwards, unless LAYERED needs it whole
         std::vector<Segment> segments[3];
+        std::vector<Segment> coded[3];
         std::vector<uint8_t> segmentationData[3];
         std::vector<uint8_t> predictionData[3];
-        std::vector<uint8_t> imageData[3];
+        ChannelConfig dataConfigs[3];
+        std::vector<std::vector<uint8_t>> dataLayers[3];
+        int bitPlanes[3] = {0, 0, 0};
+        EncodingMethod encodingMethods[3];
 
         // Process each channel
         for (int p = 0; p < 3; p++) {
@@ -66,208 +348,186 @@ std::vector<uint8_t> GlicCodec::encodeToBuffer(const Color* pixels, int width, i
                 chConfig.segmentationPrecision
             );
             segmWriter.align();
-            segmentationData[p] = std::vector<uint8_t>(segmWriter.data().begin(), segmWriter.data().end());
+            segmentationData[p] = segmWriter.data();
 
             std::cout << "Created " << segments[p].size() << " segments" << std::endl;
 
-            // Create wavelet transform if needed
-            std::shared_ptr<Wavelet> wavelet = nullptr;
-            std::unique_ptr<WaveletTransform> transform = nullptr;
-            std::unique_ptr<MagnitudeCompressor> compressor = nullptr;
-
-            if (chConfig.waveletType != WaveletType::NONE) {
-                wavelet = createWavelet(chConfig.waveletType);
-                transform = createTransform(chConfig.transformType, wavelet);
-                if (chConfig.transformCompress > 0) {
-                    compressor = std::make_unique<MagnitudeCompressor>(transCompressionValue(chConfig.transformCompress));
-                }
-            }
+            ChannelPipeline pipeline(chConfig, p);
 
-            std::cout << "Wavelet for plane " << p << " -> " << (wavelet ? wavelet->getName() : "NONE") << std::endl;
+            std::cout << "Wavelet for plane " << p << " -> " << pipeline.transformName() << std::endl;
             std::cout << "Prediction for plane " << p << " -> " << predictionName(chConfig.predictionMethod) << std::endl;
 
-            float pq = quantValue(chConfig.quantizationValue);
-
-            // Create result planes for storing encoded values
-            auto resultPlanes = planes.clone();
-
             // Process each segment
             for (auto& seg : segments[p]) {
-                // Predict
-                auto pred = predict(chConfig.predictionMethod, planes, p, seg);
-
-                // Calculate residuals
-                planes.subtract(p, seg, pred, chConfig.clampMethod);
-
-                // Quantize
-                if (pq > 0) {
-                    quantize(planes, p, seg, pq, true);
-                }
-
-                // Apply wavelet transform if enabled
-                if (transform) {
-                    auto tr = planes.getSegment(p, seg);
-                    tr = transform->forward(tr);
+                pipeline.encodeSegment(planes, *resultPlanes, seg);
+            }
 
-                    if (compressor) {
-                        tr = compressor->compress(tr);
-                    }
+            coded[p] = codedSegments(segments[p]);
+            std::cout << "Skipped " << (segments[p].size() - coded[p].size()) << " zero segments" << std::endl;
 
-                    // Store result as ints
-                    for (int x = 0; x < seg.size; x++) {
-                        for (int y = 0; y < seg.size; y++) {
-                            int val = static_cast<int>(std::round((tr[x][y] * chConfig.transformScale) / static_cast<float>(seg.size)));
-                            planes.set(p, seg.x + x, seg.y + y, val);
+            // Write prediction data, led by one skip bit per segment
+            BitWriter predWriter;
+            predWriter.reserve(segments[p].size() / 4 + 16);
+            for (const auto& seg : segments[p]) {
+                predWriter.writeBoolean(seg.skip);
+            }
+            predWriter.align();
+            writePredictionData(predWriter, segments[p]);
+            predWriter.align();
+            predictionData[p] = predWriter.data();
+
+            // Lifting coefficients are stored at the signed width that fits them all
+            ChannelConfig& dataConfig = dataConfigs[p];
+            dataConfig = chConfig;
+            if (usesLifting(chConfig)) {
+                int lo = 0, hi = 0;
+                for (const auto& seg : coded[p]) {
+                    for (int x = 0; x < seg.size && seg.x + x < width; x++) {
+                        for (int y = 0; y < seg.size && seg.y + y < height; y++) {
+                            int val = resultPlanes->get(p, seg.x + x, seg.y + y);
+                            lo = std::min(lo, val);
+                            hi = std::max(hi, val);
                         }
                     }
                 }
-
-                // Store encoding value in result planes
-                for (int x = 0; x < seg.size; x++) {
-                    for (int y = 0; y < seg.size; y++) {
-                        resultPlanes->set(p, seg.x + x, seg.y + y, planes.get(p, seg.x + x, seg.y + y));
-                    }
-                }
-
-                // Decompress now for next prediction
-                if (transform) {
-                    std::vector<std::vector<double>> tr(seg.size, std::vector<double>(seg.size));
-                    for (int x = 0; x < seg.size; x++) {
-                        for (int y = 0; y < seg.size; y++) {
-                            tr[x][y] = (seg.size * planes.get(p, seg.x + x, seg.y + y)) / static_cast<float>(chConfig.transformScale);
-                        }
-                    }
-                    tr = transform->reverse(tr);
-                    planes.setSegment(p, seg, tr, chConfig.clampMethod);
+                dataConfig.coefficientBits = 1;
+                while (lo < -(1 << (dataConfig.coefficientBits - 1)) || hi > (1 << (dataConfig.coefficientBits - 1)) - 1) {
+                    dataConfig.coefficientBits++;
                 }
+            }
 
-                // Reverse quantization
-                if (pq > 0) {
-                    quantize(planes, p, seg, pq, false);
-                }
+            encodingMethods[p] = chConfig.encodingMethod;
+            if (encodingMethods[p] == EncodingMethod::AUTO) {
+                encodingMethods[p] = chooseEncoding(*resultPlanes, p, coded[p], dataConfig);
+                std::cout << "Encoding for plane " << p << " -> " << encodingName(encodingMethods[p]) << std::endl;
+            }
 
-                // Add back predictions
-                pred = predict(seg.predType, planes, p, seg);
-                planes.add(p, seg, pred, chConfig.clampMethod);
+            if (encodingMethods[p] == EncodingMethod::HUFFMAN) {
+                dataConfig.codeLengths = huffmanCodeLengths(*resultPlanes, p, coded[p], dataConfig);
             }
 
-            // Write prediction data
-            BitWriter predWriter;
-            for (const auto& seg : segments[p]) {
-                predWriter.writeByte(static_cast<uint8_t>(seg.predType));
-                predWriter.writeBits(static_cast<uint32_t>(static_cast<int16_t>(seg.refX)), 16);
-                predWriter.writeBits(static_cast<uint32_t>(static_cast<int16_t>(seg.refY)), 16);
-                predWriter.writeByte(static_cast<uint8_t>(seg.refAngle % 3));
-                int16_t angleVal = static_cast<int16_t>(0x7000 * seg.angle);
-                predWriter.writeBits(static_cast<uint32_t>(angleVal), 16);
+            if (encodingMethods[p] == EncodingMethod::LAYERED) {
+                ChannelLayers layered = encodeLayers(*resultPlanes, p, coded[p], dataConfig);
+                bitPlanes[p] = layered.planes;
+                dataLayers[p] = std::move(layered.layers);
+                std::cout << "Layers for plane " << p << " -> " << dataLayers[p].size() << std::endl;
             }
-            predWriter.align();
-            predictionData[p] = std::vector<uint8_t>(predWriter.data().begin(), predWriter.data().end());
-
-            // Encode image data
-            BitWriter dataWriter;
-            encodeData(dataWriter, *resultPlanes, p, segments[p], chConfig.encodingMethod, chConfig);
-            imageData[p] = std::vector<uint8_t>(dataWriter.data().begin(), dataWriter.data().end());
-        }
-
-        // Build output buffer
-
-        // Magic + version
-        buffer.push_back((GLIC_MAGIC >> 24) & 0xFF);
-        buffer.push_back((GLIC_MAGIC >> 16) & 0xFF);
-        buffer.push_back((GLIC_MAGIC >> 8) & 0xFF);
-        buffer.push_back(GLIC_MAGIC & 0xFF);
-        buffer.push_back((GLIC_VERSION >> 8) & 0xFF);
-        buffer.push_back(GLIC_VERSION & 0xFF);
-
-        // Width and height
-        buffer.push_back((width >> 24) & 0xFF);
-        buffer.push_back((width >> 16) & 0xFF);
-        buffer.push_back((width >> 8) & 0xFF);
-        buffer.push_back(width & 0xFF);
-        buffer.push_back((height >> 24) & 0xFF);
-        buffer.push_back((height >> 16) & 0xFF);
-        buffer.push_back((height >> 8) & 0xFF);
-        buffer.push_back(height & 0xFF);
-
-        // Color space
-        buffer.push_back(static_cast<uint8_t>(config_.colorSpace));
-
-        // Border color
-        buffer.push_back(config_.borderColorR);
-        buffer.push_back(config_.borderColorG);
-        buffer.push_back(config_.borderColorB);
-
-        // Sizes for each channel (segmentation, prediction, image data)
-        for (int p = 0; p < 3; p++) {
-            uint32_t segSize = static_cast<uint32_t>(segmentationData[p].size());
-            buffer.push_back((segSize >> 24) & 0xFF);
-            buffer.push_back((segSize >> 16) & 0xFF);
-            buffer.push_back((segSize >> 8) & 0xFF);
-            buffer.push_back(segSize & 0xFF);
         }
+
+        bool layered = false;
+        size_t layerCount = 0;
         for (int p = 0; p < 3; p++) {
-            uint32_t predSize = static_cast<uint32_t>(predictionData[p].size());
-            buffer.push_back((predSize >> 24) & 0xFF);
-            buffer.push_back((predSize >> 16) & 0xFF);
-            buffer.push_back((predSize >> 8) & 0xFF);
-            buffer.push_back(predSize & 0xFF);
+            layered = layered || encodingMethods[p] == EncodingMethod::LAYERED;
+            layerCount = std::max(layerCount, dataLayers[p].size());
         }
+
+        // Streamed data sizes are only known at the end. Seekable sinks get
+        // the section table patched in place, others get it in a trailer.
+        // Layered data is already complete, so its table is final up front.
+        bool trailer = !layered && !sink.seekable();
+
+        ContainerInfo info;
+        info.flags = (layered ? GLIC_FLAG_LAYERED : 0) | (trailer ? GLIC_FLAG_SIZE_TRAILER : 0);
+        info.width = width;
+        info.height = height;
+        info.colorSpace = config_.colorSpace;
+        info.border[0] = config_.borderColorR;
+        info.border[1] = config_.borderColorG;
+        info.border[2] = config_.borderColorB;
         for (int p = 0; p < 3; p++) {
-            uint32_t dataSize = static_cast<uint32_t>(imageData[p].size());
-            buffer.push_back((dataSize >> 24) & 0xFF);
-            buffer.push_back((dataSize >> 16) & 0xFF);
-            buffer.push_back((dataSize >> 8) & 0xFF);
-            buffer.push_back(dataSize & 0xFF);
+            info.channels[p] = dataConfigs[p];
+            info.channels[p].encodingMethod = encodingMethods[p];
+            info.bitPlanes[p] = bitPlanes[p];
         }
 
-        // Pad header to 64 bytes
-        while (buffer.size() < GLIC_HEADER_SIZE) {
-            buffer.push_back(0);
+        // Sections in file order: segmentation, prediction, then image data.
+        // Layers are interleaved across channels, so any prefix of the file
+        // holds the first layers of all three.
+        for (int p = 0; p < 3; p++) {
+            info.sections.push_back({SectionKind::SEGMENTATION, static_cast<uint8_t>(p), 0, 0, segmentationData[p].size()});
         }
-
-        // Channel configs (32 bytes each)
         for (int p = 0; p < 3; p++) {
-            const auto& ch = config_.channels[p];
-            buffer.push_back(static_cast<uint8_t>(ch.predictionMethod));
-            buffer.push_back(static_cast<uint8_t>(ch.quantizationValue));
-            buffer.push_back(static_cast<uint8_t>(ch.clampMethod));
-            buffer.push_back(static_cast<uint8_t>(ch.waveletType));
-            buffer.push_back(static_cast<uint8_t>(ch.transformType));
-            buffer.push_back((ch.transformScale >> 24) & 0xFF);
-            buffer.push_back((ch.transformScale >> 16) & 0xFF);
-            buffer.push_back((ch.transformScale >> 8) & 0xFF);
-            buffer.push_back(ch.transformScale & 0xFF);
-            buffer.push_back(static_cast<uint8_t>(ch.encodingMethod));
-
-            // Pad to 32 bytes
-            size_t start = buffer.size();
-            while (buffer.size() < start + 32 - 10) {
-                buffer.push_back(0);
+            info.sections.push_back({SectionKind::PREDICTION, static_cast<uint8_t>(p), 0, 0, predictionData[p].size()});
+        }
+        size_t firstData = info.sections.size();
+        if (layered) {
+            for (size_t l = 0; l < layerCount; l++) {
+                for (int p = 0; p < 3; p++) {
+                    if (l < dataLayers[p].size()) {
+                        info.sections.push_back({SectionKind::DATA, static_cast<uint8_t>(p), static_cast<uint16_t>(l), 0, dataLayers[p][l].size()});
+                    }
+                }
+            }
+        } else {
+            for (int p = 0; p < 3; p++) {
+                info.sections.push_back({SectionKind::DATA, static_cast<uint8_t>(p), 0, 0, 0});
             }
         }
+        uint64_t offset = sectionTableOffset() + (trailer ? 0 : info.sections.size() * GLIC_SECTION_ENTRY_SIZE);
+        for (auto& section : info.sections) {
+            section.offset = offset;
+            offset += section.length;
+        }
 
-        // Write segmentation data
+        auto header = writeContainerHeader(info);
+        sink.write(header.data(), header.size());
+
+        // Write segmentation and prediction data
         for (int p = 0; p < 3; p++) {
-            buffer.insert(buffer.end(), segmentationData[p].begin(), segmentationData[p].end());
+            sink.write(segmentationData[p].data(), segmentationData[p].size());
         }
-
-        // Write prediction data
         for (int p = 0; p < 3; p++) {
-            buffer.insert(buffer.end(), predictionData[p].begin(), predictionData[p].end());
+            sink.write(predictionData[p].data(), predictionData[p].size());
         }
 
-        // Write image data
-        for (int p = 0; p < 3; p++) {
-            buffer.insert(buffer.end(), imageData[p].begin(), imageData[p].end());
+        if (layered) {
+            // Write image data, layer by layer
+            for (size_t l = 0; l < layerCount; l++) {
+                for (int p = 0; p < 3; p++) {
+                    if (l < dataLayers[p].size()) {
+                        sink.write(dataLayers[p][l].data(), dataLayers[p][l].size());
+                    }
+                }
+            }
+        } else {
+            // Encode image data straight into the sink, a chunk at a time
+            offset = info.sections[firstData].offset;
+            for (int p = 0; p < 3; p++) {
+                CountingSink counter(sink);
+                BitWriter dataWriter;
+                dataWriter.setOutput(&counter);
+                encodeData(dataWriter, *resultPlanes, p, coded[p], encodingMethods[p], dataConfigs[p]);
+                dataWriter.align();
+                dataWriter.flushOutput();
+
+                Section& section = info.sections[firstData + p];
+                section.offset = offset;
+                section.length = counter.count();
+                offset += section.length;
+            }
+
+            auto table = writeSectionTable(info.sections);
+            if (trailer) {
+                sink.write(table.data(), table.size());
+            } else {
+                sink.patch(sectionTableOffset(), table.data(), table.size());
+            }
         }
 
         std::cout << "FINISHED" << std::endl;
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Encoding failed: " << e.what() << std::endl;
-        buffer.clear();
+        return false;
     }
+}
 
+std::vector<uint8_t> GlicCodec::encodeToBuffer(const Color* pixels, int width, int height) {
+    std::vector<uint8_t> buffer;
+    VectorSink sink(buffer);
+    if (!encodeToSink(pixels, width, height, sink)) {
+        buffer.clear();
+    }
     return buffer;
 }
 
@@ -276,224 +536,135 @@ GlicResult GlicCodec::encode(const Color* pixels, int width, int height, const s
     result.width = width;
     result.height = height;
 
-    auto buffer = encodeToBuffer(pixels, width, height);
-    if (buffer.empty()) {
+    if (!validDimensions(width, height)) {
         result.success = false;
-        result.error = "Encoding failed";
+        result.error = "Invalid image dimensions";
         return result;
     }
 
-    std::ofstream file(outputPath, std::ios::binary);
+    // Encode into a new file next to the output and move it into place once
+    // complete, so a failed encode leaves any existing file untouched
+    std::string tempPath;
+    std::FILE* file = createTempFile(outputPath, tempPath);
     if (!file) {
         result.success = false;
         result.error = "Failed to open output file";
         return result;
     }
 
-    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
-    file.close();
+    FileSink sink(file);
+    bool encoded = encodeToSink(pixels, width, height, sink);
+    bool closed = std::fclose(file) == 0;
+    if (!encoded || !closed) {
+        std::remove(tempPath.c_str());
+        result.success = false;
+        result.error = "Encoding failed";
+        return result;
+    }
+
+    if (!replaceFile(tempPath, outputPath)) {
+        std::remove(tempPath.c_str());
+        result.success = false;
+        result.error = "Failed to write output file";
+        return result;
+    }
 
     result.success = true;
     return result;
 }
 
 GlicResult GlicCodec::decodeFromBuffer(const std::vector<uint8_t>& buffer) {
+    return decodeFromBuffer(buffer.data(), buffer.size());
+}
+
+GlicResult GlicCodec::decodeFromBuffer(const uint8_t* buffer, size_t size) {
     GlicResult result;
 
     try {
         std::cout << "Decoding started" << std::endl;
 
-        if (buffer.size() < GLIC_HEADER_SIZE + 3 * GLIC_CHANNEL_HEADER_SIZE) {
-            result.error = "Buffer too small";
-            return result;
-        }
-
-        size_t pos = 0;
-
-        // Read magic
-        uint32_t magic = (static_cast<uint32_t>(buffer[pos]) << 24) |
-                        (static_cast<uint32_t>(buffer[pos + 1]) << 16) |
-                        (static_cast<uint32_t>(buffer[pos + 2]) << 8) |
-                        static_cast<uint32_t>(buffer[pos + 3]);
-        pos += 4;
-
-        if (magic != GLIC_MAGIC) {
-            result.error = "Invalid file format";
+        ContainerInfo info;
+        if (!readContainer(buffer, size, info, result.error)) {
             return result;
         }
 
-        // Skip version
-        pos += 2;
-
-        // Read dimensions
-        int width = (static_cast<int>(buffer[pos]) << 24) |
-                   (static_cast<int>(buffer[pos + 1]) << 16) |
-                   (static_cast<int>(buffer[pos + 2]) << 8) |
-                   static_cast<int>(buffer[pos + 3]);
-        pos += 4;
-
-        int height = (static_cast<int>(buffer[pos]) << 24) |
-                    (static_cast<int>(buffer[pos + 1]) << 16) |
-                    (static_cast<int>(buffer[pos + 2]) << 8) |
-                    static_cast<int>(buffer[pos + 3]);
-        pos += 4;
-
+        int width = info.width;
+        int height = info.height;
         result.width = width;
         result.height = height;
-
-        // Read color space
-        ColorSpace colorSpace = static_cast<ColorSpace>(buffer[pos++]);
-        std::cout << "Color space: " << colorSpaceName(colorSpace) << std::endl;
-
-        // Read border color
-        uint8_t borderR = buffer[pos++];
-        uint8_t borderG = buffer[pos++];
-        uint8_t borderB = buffer[pos++];
-
-        // Read sizes
-        uint32_t segmentationSizes[3];
-        uint32_t predictionSizes[3];
-        uint32_t dataSizes[3];
-
-        for (int p = 0; p < 3; p++) {
-            segmentationSizes[p] = (static_cast<uint32_t>(buffer[pos]) << 24) |
-                                   (static_cast<uint32_t>(buffer[pos + 1]) << 16) |
-                                   (static_cast<uint32_t>(buffer[pos + 2]) << 8) |
-                                   static_cast<uint32_t>(buffer[pos + 3]);
-            pos += 4;
-        }
-        for (int p = 0; p < 3; p++) {
-            predictionSizes[p] = (static_cast<uint32_t>(buffer[pos]) << 24) |
-                                 (static_cast<uint32_t>(buffer[pos + 1]) << 16) |
-                                 (static_cast<uint32_t>(buffer[pos + 2]) << 8) |
-                                 static_cast<uint32_t>(buffer[pos + 3]);
-            pos += 4;
-        }
-        for (int p = 0; p < 3; p++) {
-            dataSizes[p] = (static_cast<uint32_t>(buffer[pos]) << 24) |
-                          (static_cast<uint32_t>(buffer[pos + 1]) << 16) |
-                          (static_cast<uint32_t>(buffer[pos + 2]) << 8) |
-                          static_cast<uint32_t>(buffer[pos + 3]);
-            pos += 4;
-        }
-
-        // Skip to end of header
-        pos = GLIC_HEADER_SIZE;
-
-        // Read channel configs
-        ChannelConfig channelConfigs[3];
-        for (int p = 0; p < 3; p++) {
-            channelConfigs[p].predictionMethod = static_cast<PredictionMethod>(static_cast<int8_t>(buffer[pos++]));
-            channelConfigs[p].quantizationValue = buffer[pos++];
-            channelConfigs[p].clampMethod = static_cast<ClampMethod>(buffer[pos++]);
-            channelConfigs[p].waveletType = static_cast<WaveletType>(buffer[pos++]);
-            channelConfigs[p].transformType = static_cast<TransformType>(buffer[pos++]);
-            channelConfigs[p].transformScale = (static_cast<int>(buffer[pos]) << 24) |
-                                               (static_cast<int>(buffer[pos + 1]) << 16) |
-                                               (static_cast<int>(buffer[pos + 2]) << 8) |
-                                               static_cast<int>(buffer[pos + 3]);
-            pos += 4;
-            channelConfigs[p].encodingMethod = static_cast<EncodingMethod>(buffer[pos++]);
-
-            // Skip padding
-            pos += GLIC_CHANNEL_HEADER_SIZE - 10;
-        }
+        std::cout << "Color space: " << colorSpaceName(info.colorSpace) << std::endl;
 
         // Create planes
-        RefColor ref(makeColor(borderR, borderG, borderB), colorSpace);
-        Planes planes(width, height, colorSpace, ref);
-
-        // Calculate padded dimensions
-        int ww = 1;
-        while (ww < width) ww *= 2;
-        int hh = 1;
-        while (hh < height) hh *= 2;
+        RefColor ref(makeColor(info.border[0], info.border[1], info.border[2]), info.colorSpace);
+        Planes planes(width, height, info.colorSpace, ref);
 
-        // Read segmentation data and reconstruct segments
-        std::vector<Segment> segments[3];
-        for (int p = 0; p < 3; p++) {
-            std::cout << "Channel " << p << " segmentation" << std::endl;
-            BitReader segReader(buffer.data() + pos, segmentationSizes[p]);
-            segments[p] = readSegmentation(segReader, ww, hh, width, height);
-            pos += segmentationSizes[p];
+        // Thumbnails are reconstructed into planes of the reduced size
+        int factor = decodeOptions_.downscale;
+        if (factor < 1 || (factor & (factor - 1)) != 0) {
+            result.error = "Downscale must be a power of two";
+            return result;
         }
-
-        // Read prediction data
-        for (int p = 0; p < 3; p++) {
-            BitReader predReader(buffer.data() + pos, predictionSizes[p]);
-            for (auto& seg : segments[p]) {
-                try {
-                    seg.predType = static_cast<PredictionMethod>(predReader.readByte());
-                    if (seg.predType == PredictionMethod::NONE) {
-                        seg.predType = channelConfigs[p].predictionMethod;
-                    }
-                    seg.refX = static_cast<int16_t>(predReader.readBits(16));
-                    seg.refY = static_cast<int16_t>(predReader.readBits(16));
-                    seg.refAngle = predReader.readByte() % 3;
-                    int16_t angleVal = static_cast<int16_t>(predReader.readBits(16));
-                    seg.angle = static_cast<float>(angleVal) / 0x7000;
-                } catch (...) {
-                    break;
-                }
+        std::unique_ptr<Planes> reduced;
+        if (factor > 1) {
+            if (decodeOptions_.useRegion) {
+                result.error = "Region and downscale cannot be combined";
+                return result;
             }
-            pos += predictionSizes[p];
+            width = (width + factor - 1) / factor;
+            height = (height + factor - 1) / factor;
+            result.width = width;
+            result.height = height;
+            reduced = std::make_unique<Planes>(width, height, info.colorSpace, ref);
         }
 
-        // Read and decode image data
-        for (int p = 0; p < 3; p++) {
-            BitReader dataReader(buffer.data() + pos, dataSizes[p]);
-            decodeData(dataReader, planes, p, segments[p], channelConfigs[p].encodingMethod, channelConfigs[p]);
-            pos += dataSizes[p];
+        // Channels are independent; a single-channel decode seeks straight
+        // to that channel's sections
+        int only = decodeOptions_.channel;
+        if (only > 2) {
+            result.error = "Invalid channel";
+            return result;
         }
 
-        // Reconstruct image
+        PixelRect region{0, 0, width, height};
+        if (decodeOptions_.useRegion) {
+            region = {decodeOptions_.regionX, decodeOptions_.regionY,
+                      decodeOptions_.regionWidth, decodeOptions_.regionHeight};
+            if (region.w <= 0 || region.h <= 0) {
+                result.error = "Empty region";
+                return result;
+            }
+            if (region.x < 0 || region.y < 0 || region.x + region.w > width || region.y + region.h > height) {
+                result.error = "Region outside image";
+                return result;
+            }
+            result.width = region.w;
+            result.height = region.h;
+        }
         for (int p = 0; p < 3; p++) {
-            const auto& chConfig = channelConfigs[p];
-
-            std::shared_ptr<Wavelet> wavelet = nullptr;
-            std::unique_ptr<WaveletTransform> transform = nullptr;
-
-            if (chConfig.waveletType != WaveletType::NONE) {
-                wavelet = createWavelet(chConfig.waveletType);
-                transform = createTransform(chConfig.transformType, wavelet);
+            if (only >= 0 && p != only) continue;
+            if (!decodeChannel(buffer, size, info, p, region, planes, result.error, factor, reduced.get())) {
+                return result;
             }
+        }
 
-            std::cout << "Wavelet for plane " << p << " -> " << (wavelet ? wavelet->getName() : "NONE") << std::endl;
-            std::cout << "Prediction for plane " << p << " -> " << predictionName(chConfig.predictionMethod) << std::endl;
-
-            float pq = quantValue(chConfig.quantizationValue);
-
-            for (auto& seg : segments[p]) {
-                // Inverse wavelet transform
-                if (transform) {
-                    std::vector<std::vector<double>> tr(seg.size, std::vector<double>(seg.size));
-                    for (int x = 0; x < seg.size; x++) {
-                        for (int y = 0; y < seg.size; y++) {
-                            tr[x][y] = (seg.size * planes.get(p, seg.x + x, seg.y + y)) / static_cast<float>(chConfig.transformScale);
-                        }
-                    }
-                    tr = transform->reverse(tr);
-                    planes.setSegment(p, seg, tr, chConfig.clampMethod);
-                }
-
-                // Inverse quantization
-                if (pq > 0) {
-                    quantize(planes, p, seg, pq, false);
+        // Convert the region to pixels
+        const Planes& output = reduced ? *reduced : planes;
+        if (only >= 0) {
+            result.pixels.resize(static_cast<size_t>(region.w) * region.h);
+            for (int y = 0; y < region.h; y++) {
+                for (int x = 0; x < region.w; x++) {
+                    auto v = static_cast<uint8_t>(std::max(0, std::min(255, output.get(only, region.x + x, region.y + y))));
+                    result.pixels[static_cast<size_t>(y) * region.w + x] = makeColor(v, v, v);
                 }
-
-                // Add predictions
-                auto pred = predict(seg.predType, planes, p, seg);
-                planes.add(p, seg, pred, chConfig.clampMethod);
             }
+        } else {
+            result.pixels = output.toPixels(region.x, region.y, region.w, region.h);
         }
 
-        // Convert to pixels
-        result.pixels = planes.toPixels();
-
         // Apply post-processing effects
         if (postEffects_.enabled && !postEffects_.effects.empty()) {
             std::cout << "Applying " << postEffects_.effects.size() << " post effect(s)" << std::endl;
-            applyEffects(result.pixels, width, height, postEffects_.effects);
+            applyEffects(result.pixels, region.w, region.h, postEffects_.effects);
         }
 
         result.success = true;
@@ -510,22 +681,65 @@ GlicResult GlicCodec::decodeFromBuffer(const std::vector<uint8_t>& buffer) {
 GlicResult GlicCodec::decode(const std::string& inputPath) {
     GlicResult result;
 
-    std::ifstream file(inputPath, std::ios::binary | std::ios::ate);
-    if (!file) {
+    // Sections are read in place from the mapping; nothing is copied
+    MappedFile file;
+    if (!file.open(inputPath)) {
         result.error = "Failed to open input file";
         return result;
     }
 
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    return decodeFromBuffer(file.data(), file.size());
+}
 
-    std::vector<uint8_t> buffer(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
-        result.error = "Failed to read file";
-        return result;
+GlicInfo probe(const uint8_t* data, size_t size, bool countSegments) {
+    GlicInfo result;
+
+    try {
+        if (!readContainer(data, size, result.container, result.error, countSegments)) {
+            return result;
+        }
+
+        if (countSegments) {
+            for (int p = 0; p < 3; p++) {
+                LayerSpan span = sectionSpan(data, size, result.container.find(SectionKind::SEGMENTATION, p));
+                if (!span.data) {
+                    result.error = "Truncated file";
+                    return result;
+                }
+                result.segments[p] = static_cast<int>(readSegments(result.container, span).size());
+            }
+        }
+
+        result.success = true;
+    } catch (const std::exception& e) {
+        result.error = std::string("Probe failed: ") + e.what();
     }
 
-    return decodeFromBuffer(buffer);
+    return result;
+}
+
+GlicInfo probe(const std::string& path, bool countSegments) {
+    if (countSegments) {
+        MappedFile file;
+        if (!file.open(path)) {
+            GlicInfo result;
+            result.error = "Failed to open input file";
+            return result;
+        }
+        return probe(file.data(), file.size(), true);
+    }
+
+    // Only the fixed-size headers are read from the file
+    std::vector<uint8_t> head(sectionTableOffset());
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        GlicInfo result;
+        result.error = "Failed to open input file";
+        return result;
+    }
+    size_t size = std::fread(head.data(), 1, head.size(), file);
+    std::fclose(file);
+    return probe(head.data(), size, false);
 }
 
 bool loadImage(const std::string& path, std::vector<Color>& pixels, int& width, int& height) {
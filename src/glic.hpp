@@ -1,6 +1,8 @@
 #pragma once
 
+#include "bitio.hpp"
 #include "config.hpp"
+#include "container.hpp"
 #include "effects.hpp"
 #include "planes.hpp"
 #include "segment.hpp"
@@ -19,6 +21,14 @@ struct GlicResult {
     std::string error;
 };
 
+// Metadata of a GLIC file, read without decoding it
+struct GlicInfo {
+    ContainerInfo container;
+    int segments[3] = {-1, -1, -1};  // Per channel, when counted
+    bool success = false;
+    std::string error;
+};
+
 // Main GLIC codec class
 class GlicCodec {
 public:
@@ -36,11 +46,23 @@ public:
     // Decode GLIC file to image
     GlicResult decode(const std::string& inputPath);
 
+    // Decoder options (e.g. decoding a single channel)
+    void setDecodeOptions(const DecodeOptions& options);
+    DecodeOptions& decodeOptions() { return decodeOptions_; }
+    const DecodeOptions& decodeOptions() const { return decodeOptions_; }
+
     // Encode to memory buffer
     std::vector<uint8_t> encodeToBuffer(const Color* pixels, int width, int height);
 
-    // Decode from memory buffer
+    // Encode to a sink. Image data is streamed as it is coded, so memory
+    // does not grow with the output (except for progressive layers).
+    // Images outside validDimensions() are refused.
+    bool encodeToSink(const Color* pixels, int width, int height, ByteSink& sink);
+
+    // Decode from memory buffer. The pointer form reads the bytes in place
+    // (e.g. a memory-mapped file) and needs them only for the call.
     GlicResult decodeFromBuffer(const std::vector<uint8_t>& buffer);
+    GlicResult decodeFromBuffer(const uint8_t* data, size_t size);
 
     // Post-processing effects
     void setPostEffects(const PostEffectsConfig& effects);
@@ -50,13 +72,14 @@ public:
 private:
     CodecConfig config_;
     PostEffectsConfig postEffects_;
+    DecodeOptions decodeOptions_;
 };
 
-// File format constants
-constexpr uint32_t GLIC_MAGIC = 0x474C4332; // "GLC2"
-constexpr uint16_t GLIC_VERSION = 1;
-constexpr size_t GLIC_HEADER_SIZE = 64;
-constexpr size_t GLIC_CHANNEL_HEADER_SIZE = 32;
+// Read a file's header and channel headers only (its first 160 bytes).
+// With countSegments the segmentation sections are parsed as well, for the
+// segment count of each channel; nothing else is decoded.
+GlicInfo probe(const uint8_t* data, size_t size, bool countSegments = false);
+GlicInfo probe(const std::string& path, bool countSegments = false);
 
 // Load image from file (PNG, JPG, BMP)
 bool loadImage(const std::string& path, std::vector<Color>& pixels, int& width, int& height);
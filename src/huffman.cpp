@@ -0,0 +1,155 @@
+#include "huffman.hpp"
+#include <algorithm>
+#include <queue>
+
+namespace glic {
+
+namespace {
+
+// Unlimited Huffman code lengths from counts
+std::vector<uint8_t> buildLengths(const std::vector<uint32_t>& counts) {
+    struct Node {
+        uint64_t weight;
+        int left;
+        int right;
+    };
+    std::vector<Node> nodes;
+    using Item = std::pair<uint64_t, int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+
+    for (size_t s = 0; s < counts.size(); s++) {
+        if (counts[s] > 0) {
+            queue.push({counts[s], static_cast<int>(nodes.size())});
+            nodes.push_back({counts[s], -1, static_cast<int>(s)});
+        }
+    }
+
+    std::vector<uint8_t> lengths(counts.size(), 0);
+    if (nodes.size() == 1) {
+        lengths[nodes[0].right] = 1;
+        return lengths;
+    }
+
+    while (queue.size() > 1) {
+        Item a = queue.top();
+        queue.pop();
+        Item b = queue.top();
+        queue.pop();
+        queue.push({a.first + b.first, static_cast<int>(nodes.size())});
+        nodes.push_back({a.first + b.first, a.second, b.second});
+    }
+
+    // Walk down from the root; leaves keep their symbol in `right`
+    std::vector<std::pair<int, int>> stack;
+    if (!queue.empty()) {
+        stack.push_back({queue.top().second, 0});
+    }
+    while (!stack.empty()) {
+        auto [index, depth] = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[index];
+        if (node.left < 0) {
+            lengths[node.right] = static_cast<uint8_t>(std::min(depth, 255));
+        } else {
+            stack.push_back({node.left, depth + 1});
+            stack.push_back({node.right, depth + 1});
+        }
+    }
+    return lengths;
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> huffmanLengths(const std::vector<uint32_t>& counts) {
+    if (counts.empty()) return {};
+
+    // Flatten the distribution until the longest code fits
+    std::vector<uint32_t> scaled = counts;
+    while (true) {
+        std::vector<uint8_t> lengths = buildLengths(scaled);
+        if (*std::max_element(lengths.begin(), lengths.end()) <= HUFFMAN_MAX_LENGTH) {
+            return lengths;
+        }
+        for (auto& c : scaled) {
+            if (c > 0) c = (c + 1) / 2;
+        }
+    }
+}
+
+bool HuffmanCode::build(const std::vector<uint8_t>& lengths, uint32_t stopSymbol) {
+    lengths_ = lengths;
+    codes_.assign(lengths.size(), 0);
+    std::fill(std::begin(lengthCount_), std::end(lengthCount_), 0);
+
+    for (uint8_t len : lengths) {
+        if (len > HUFFMAN_MAX_LENGTH) return false;
+        if (len > 0) lengthCount_[len]++;
+    }
+
+    // Kraft inequality, then canonical first codes per length
+    uint32_t code = 0;
+    uint32_t index = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_LENGTH; len++) {
+        code = (code + lengthCount_[len - 1]) << 1;
+        firstCode_[len] = code;
+        firstIndex_[len] = index;
+        index += lengthCount_[len];
+        if (lengthCount_[len] > 0 && code + lengthCount_[len] > (1u << len)) return false;
+    }
+
+    sorted_.clear();
+    for (int len = 1; len <= HUFFMAN_MAX_LENGTH; len++) {
+        uint32_t next = firstCode_[len];
+        for (size_t s = 0; s < lengths.size(); s++) {
+            if (lengths[s] == len) {
+                codes_[s] = next++;
+                sorted_.push_back(static_cast<uint32_t>(s));
+            }
+        }
+    }
+
+    // Multi-symbol decode table: greedily decode codes from each index
+    // until the bits run out, a stop symbol appears or the entry is full
+    table_.assign(size_t(1) << HUFFMAN_TABLE_BITS, Entry{0, 0, {0, 0, 0}});
+    for (uint32_t bits = 0; bits < table_.size(); bits++) {
+        Entry& e = table_[bits];
+        int used = 0;
+        while (e.count < HUFFMAN_TABLE_SYMBOLS) {
+            int len = 0;
+            uint32_t rest = (bits << used) & ((1u << HUFFMAN_TABLE_BITS) - 1);
+            int s = decodePrefix(rest, HUFFMAN_TABLE_BITS - used, len);
+            if (s < 0) break;
+            e.symbols[e.count++] = static_cast<uint8_t>(s);
+            used += len;
+            if (static_cast<uint32_t>(s) >= stopSymbol) break;
+        }
+        e.length = static_cast<uint8_t>(used);
+    }
+    return true;
+}
+
+int HuffmanCode::decodePrefix(uint32_t bits, int avail, int& length) const {
+    for (int len = 1; len <= avail; len++) {
+        uint32_t code = bits >> (HUFFMAN_TABLE_BITS - len);
+        uint32_t offset = code - firstCode_[len];
+        if (code >= firstCode_[len] && offset < lengthCount_[len]) {
+            length = len;
+            return static_cast<int>(sorted_[firstIndex_[len] + offset]);
+        }
+    }
+    return -1;
+}
+
+int HuffmanCode::decodeSlow(BitReader& reader) const {
+    uint32_t code = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_LENGTH; len++) {
+        code = (code << 1) | reader.readBits(1);
+        uint32_t offset = code - firstCode_[len];
+        if (code >= firstCode_[len] && offset < lengthCount_[len]) {
+            return static_cast<int>(sorted_[firstIndex_[len] + offset]);
+        }
+    }
+    return -1;
+}
+
+} // namespace glic
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "bitio.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace glic {
+
+constexpr int HUFFMAN_MAX_LENGTH = 15;
+// Bits resolved per decode table probe
+constexpr int HUFFMAN_TABLE_BITS = 11;
+// Most symbols one probe can yield
+constexpr int HUFFMAN_TABLE_SYMBOLS = 3;
+
+// Code lengths (at most HUFFMAN_MAX_LENGTH, 0 = unused) for symbol counts
+std::vector<uint8_t> huffmanLengths(const std::vector<uint32_t>& counts);
+
+// Canonical Huffman code rebuilt from code lengths alone
+class HuffmanCode {
+public:
+    // One decode table probe: up to HUFFMAN_TABLE_SYMBOLS symbols and the
+    // code bits they use. count 0 means the next code is longer than the
+    // table and needs decodeSlow().
+    struct Entry {
+        uint8_t count;
+        uint8_t length;
+        uint8_t symbols[HUFFMAN_TABLE_SYMBOLS];
+    };
+
+    // Returns false if the lengths do not form a prefix code. Symbols at or
+    // above stopSymbol end a table entry (they carry extra bits).
+    bool build(const std::vector<uint8_t>& lengths, uint32_t stopSymbol);
+
+    uint32_t code(uint32_t symbol) const { return codes_[symbol]; }
+    int length(uint32_t symbol) const { return lengths_[symbol]; }
+
+    const Entry& lookup(uint32_t bits) const { return table_[bits]; }
+
+    // Bit-by-bit canonical decode; -1 if no code matches
+    int decodeSlow(BitReader& reader) const;
+
+private:
+    // Decode one symbol from the top `avail` bits of `bits`, or -1
+    int decodePrefix(uint32_t bits, int avail, int& length) const;
+
+    std::vector<uint8_t> lengths_;
+    std::vector<uint32_t> codes_;
+    std::vector<uint32_t> sorted_;  // symbols ordered by (length, symbol)
+    uint32_t firstCode_[HUFFMAN_MAX_LENGTH + 1] = {};
+    uint32_t lengthCount_[HUFFMAN_MAX_LENGTH + 1] = {};
+    uint32_t firstIndex_[HUFFMAN_MAX_LENGTH + 1] = {};
+    std::vector<Entry> table_;
+};
+
+} // namespace glic
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 
 using namespace glic;
@@ -13,7 +14,8 @@ void printUsage(const char* programName) {
     std::cout << "GLIC - GLitch Image Codec (C++ Version)\n\n";
     std::cout << "Usage:\n";
     std::cout << "  " << programName << " encode <input.png> <output.glic> [options]\n";
-    std::cout << "  " << programName << " decode <input.glic> <output.png> [options]\n\n";
+    std::cout << "  " << programName << " decode <input.glic> <output.png> [options]\n";
+    std::cout << "  " << programName << " info <input.glic> [--segments]\n\n";
     std::cout << "Encode Options:\n";
     std::cout << "  --colorspace <name>      Color space (default: HWB)\n";
     std::cout << "                           Options: RGB, HSB, HWB, OHTA, CMY, XYZ, YXY, LAB, LUV,\n";
@@ -30,12 +32,26 @@ void printUsage(const char* programName) {
     std::cout << "  --quantization <value>   Quantization value 0-255 (default: 110)\n";
     std::cout << "  --clamp <method>         Clamp method: none, mod256 (default: none)\n";
     std::cout << "  --wavelet <name>         Wavelet type (default: SYMLET8)\n";
-    std::cout << "                           Options: NONE, HAAR, DB2-DB10, SYM2-SYM10, COIF1-COIF5\n";
-    std::cout << "  --transform <type>       Transform type: fwt, wpt (default: fwt)\n";
+    std::cout << "                           Options: NONE, HAAR, DB2-DB10, SYM2-SYM10, COIF1-COIF5, LG53\n";
+    std::cout << "  --transform <type>       Transform type: fwt, wpt, lifting (default: fwt)\n";
+    std::cout << "                           lifting = integer LeGall 5/3, lossless\n";
     std::cout << "  --scale <value>          Transform scale (default: 20)\n";
+    std::cout << "  --compress <value>       Zero transform coefficients below a threshold 0-255 (default: 0)\n";
     std::cout << "  --encoding <method>      Encoding method (default: packed)\n";
-    std::cout << "                           Options: raw, packed, rle, delta, xor, zigzag\n";
+    std::cout << "                           Options: raw, packed, rle, delta, xor, zigzag, rans,\n";
+    std::cout << "                                    rice, huffman, blockpack, sigmap,\n";
+    std::cout << "                                    auto (smallest per channel)\n";
+    std::cout << "  --progressive            Store bit-plane quality layers; a prefix of the\n";
+    std::cout << "                           file decodes to a lower-fidelity preview\n";
     std::cout << "  --border <r,g,b>         Border color RGB (default: 128,128,128)\n";
+    std::cout << "\nInfo Options:\n";
+    std::cout << "  --segments               Also count each channel's segments (reads the\n";
+    std::cout << "                           segmentation sections; otherwise only the headers)\n";
+    std::cout << "\nDecode Options:\n";
+    std::cout << "  --channel <0-2>          Decode one channel only, as grayscale (e.g. 0 for\n";
+    std::cout << "                           luma in YUV files); other channels are not read\n";
+    std::cout << "  --region <x,y,w,h>       Decode only this rectangle (e.g. a viewport)\n";
+    std::cout << "  --downscale <n>          Decode a thumbnail at 1/n size (n = 2, 4, 8...)\n";
     std::cout << "\nDecode Options (Post-Effects):\n";
     std::cout << "  --effect <name>          Apply post effect (can be used multiple times)\n";
     std::cout << "                           Options: pixelate, scanline, chromatic, dither,\n";
@@ -48,10 +64,51 @@ void printUsage(const char* programName) {
     std::cout << "  " << programName << " encode photo.png glitched.glic\n";
     std::cout << "  " << programName << " encode photo.png glitched.glic --colorspace HWB --prediction SPIRAL\n";
     std::cout << "  " << programName << " decode glitched.glic result.png --effect scanline --effect chromatic\n";
+    std::cout << "  " << programName << " info glitched.glic\n";
+}
+
+// Print a file's metadata as JSON, from its headers alone
+int printInfo(const std::string& path, bool countSegments) {
+    GlicInfo info = probe(path, countSegments);
+    if (!info.success) {
+        std::cerr << "Error: " << info.error << std::endl;
+        return 1;
+    }
+
+    const auto& c = info.container;
+    std::cout << "{\n";
+    std::cout << "  \"version\": " << c.version << ",\n";
+    std::cout << "  \"width\": " << c.width << ",\n";
+    std::cout << "  \"height\": " << c.height << ",\n";
+    std::cout << "  \"colorspace\": \"" << colorSpaceName(c.colorSpace) << "\",\n";
+    std::cout << "  \"border\": [" << int(c.border[0]) << ", " << int(c.border[1]) << ", " << int(c.border[2]) << "],\n";
+    std::cout << "  \"progressive\": " << ((c.flags & GLIC_FLAG_LAYERED) ? "true" : "false") << ",\n";
+    std::cout << "  \"channels\": [\n";
+    for (int p = 0; p < 3; p++) {
+        const auto& ch = c.channels[p];
+        const char* transform = ch.transformType == TransformType::WPT ? "wpt" :
+                                ch.transformType == TransformType::LIFTING ? "lifting" : "fwt";
+        std::cout << "    {";
+        std::cout << "\"prediction\": \"" << predictionName(ch.predictionMethod) << "\", ";
+        std::cout << "\"quantization\": " << ch.quantizationValue << ", ";
+        std::cout << "\"clamp\": \"" << (ch.clampMethod == ClampMethod::MOD256 ? "mod256" : "none") << "\", ";
+        std::cout << "\"wavelet\": \"" << waveletName(ch.waveletType) << "\", ";
+        std::cout << "\"transform\": \"" << transform << "\", ";
+        std::cout << "\"scale\": " << ch.transformScale << ", ";
+        std::cout << "\"encoding\": \"" << encodingName(ch.encodingMethod) << "\"";
+        if (info.segments[p] >= 0) {
+            std::cout << ", \"segments\": " << info.segments[p];
+        }
+        std::cout << "}" << (p < 2 ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n";
+    std::cout << "}" << std::endl;
+    return 0;
 }
 
 bool parseArgs(int argc, char* argv[], std::string& command, std::string& input,
-               std::string& output, CodecConfig& config, PostEffectsConfig& postEffects) {
+               std::string& output, CodecConfig& config, PostEffectsConfig& postEffects,
+               DecodeOptions& decodeOptions) {
     if (argc < 4) {
         return false;
     }
@@ -63,6 +120,7 @@ bool parseArgs(int argc, char* argv[], std::string& command, std::string& input,
     // Default config
     config = CodecConfig();
     postEffects = PostEffectsConfig();
+    decodeOptions = DecodeOptions();
 
     // Default effect config for new effects
     EffectConfig currentEffect;
@@ -110,15 +168,25 @@ bool parseArgs(int argc, char* argv[], std::string& command, std::string& input,
         }
         else if (arg == "--transform" && i + 1 < argc) {
             std::string val = argv[++i];
-            TransformType tt = (val == "wpt") ? TransformType::WPT : TransformType::FWT;
+            TransformType tt = (val == "wpt") ? TransformType::WPT :
+                               (val == "lifting") ? TransformType::LIFTING : TransformType::FWT;
             for (auto& ch : config.channels) ch.transformType = tt;
         }
         else if (arg == "--scale" && i + 1 < argc) {
             int val = std::stoi(argv[++i]);
             for (auto& ch : config.channels) ch.transformScale = val;
         }
+        else if (arg == "--progressive") {
+            for (auto& ch : config.channels) ch.encodingMethod = EncodingMethod::LAYERED;
+        }
+        else if (arg == "--compress" && i + 1 < argc) {
+            float val = std::stof(argv[++i]);
+            for (auto& ch : config.channels) ch.transformCompress = val;
+        }
         else if (arg == "--encoding" && i + 1 < argc) {
-            auto val = encodingFromName(argv[++i]);
+            std::string name = argv[++i];
+            std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+            auto val = encodingFromName(name);
             for (auto& ch : config.channels) ch.encodingMethod = val;
         }
         else if (arg == "--border" && i + 1 < argc) {
@@ -130,6 +198,24 @@ bool parseArgs(int argc, char* argv[], std::string& command, std::string& input,
                 config.borderColorB = static_cast<uint8_t>(b);
             }
         }
+        // Decode options
+        else if (arg == "--channel" && i + 1 < argc) {
+            decodeOptions.channel = std::stoi(argv[++i]);
+        }
+        else if (arg == "--region" && i + 1 < argc) {
+            std::string regionStr = argv[++i];
+            int x = 0, y = 0, w = 0, h = 0;
+            if (sscanf(regionStr.c_str(), "%d,%d,%d,%d", &x, &y, &w, &h) == 4) {
+                decodeOptions.useRegion = true;
+                decodeOptions.regionX = x;
+                decodeOptions.regionY = y;
+                decodeOptions.regionWidth = w;
+                decodeOptions.regionHeight = h;
+            }
+        }
+        else if (arg == "--downscale" && i + 1 < argc) {
+            decodeOptions.downscale = std::stoi(argv[++i]);
+        }
         // Post-effect options
         else if (arg == "--effect" && i + 1 < argc) {
             std::string effectName = argv[++i];
@@ -166,11 +252,18 @@ bool parseArgs(int argc, char* argv[], std::string& command, std::string& input,
 }
 
 int main(int argc, char* argv[]) {
+    // info takes no output path
+    if (argc >= 3 && std::strcmp(argv[1], "info") == 0) {
+        bool countSegments = argc >= 4 && std::strcmp(argv[3], "--segments") == 0;
+        return printInfo(argv[2], countSegments);
+    }
+
     std::string command, input, output;
     CodecConfig config;
     PostEffectsConfig postEffects;
+    DecodeOptions decodeOptions;
 
-    if (!parseArgs(argc, argv, command, input, output, config, postEffects)) {
+    if (!parseArgs(argc, argv, command, input, output, config, postEffects, decodeOptions)) {
         printUsage(argv[0]);
         return 1;
     }
@@ -179,6 +272,7 @@ int main(int argc, char* argv[]) {
 
     GlicCodec codec(config);
     codec.setPostEffects(postEffects);
+    codec.setDecodeOptions(decodeOptions);
 
     if (command == "encode") {
         // Load input image
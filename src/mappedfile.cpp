@@ -0,0 +1,75 @@
+#include "mappedfile.hpp"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GLIC_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace glic {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef GLIC_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            // The whole file is read front to back
+            madvise(addr, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const uint8_t*>(addr);
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_ || size_ == 0) {
+        return true;
+    }
+#endif
+
+    // No mapping: read the file instead
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    size_ = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    fallback_.resize(size_);
+    if (!file.read(reinterpret_cast<char*>(fallback_.data()), size_)) {
+        close();
+        return false;
+    }
+    data_ = fallback_.data();
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef GLIC_HAVE_MMAP
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+}
+
+} // namespace glic
@@ -0,0 +1,316 @@
+#include "pipeline.hpp"
+#include "prediction.hpp"
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+namespace glic {
+
+namespace {
+
+// Upper bound on samples gathered into one transform batch
+constexpr size_t MAX_BATCH_SAMPLES = 1 << 16;
+
+// Group segments by size for batched transforms
+std::map<int, std::vector<const Segment*>> groupBySize(const std::vector<Segment>& segments) {
+    std::map<int, std::vector<const Segment*>> bySize;
+    for (const auto& seg : segments) {
+        bySize[seg.size].push_back(&seg);
+    }
+    return bySize;
+}
+
+} // anonymous namespace
+
+bool insidePlanes(const Planes& planes, const Segment& seg) {
+    return seg.x + seg.size <= planes.width() && seg.y + seg.size <= planes.height();
+}
+
+ChannelPipeline::ChannelPipeline(const ChannelConfig& config, int channel)
+    : config_(config), channel_(channel), quant_(quantValue(config.quantizationValue)) {
+    if (usesLifting(config)) {
+        lifting_ = std::make_unique<LiftingTransform>();
+    } else if (config.waveletType != WaveletType::NONE) {
+        wavelet_ = createWavelet(config.waveletType);
+        transform_ = createTransform(config.transformType, wavelet_);
+        if (config.transformCompress > 0) {
+            compressor_ = std::make_unique<MagnitudeCompressor>(transCompressionValue(config.transformCompress));
+        }
+    }
+}
+
+std::string ChannelPipeline::transformName() const {
+    if (lifting_) return "LeGall5/3";
+    return wavelet_ ? wavelet_->getName() : "NONE";
+}
+
+void ChannelPipeline::resetOutside(const Planes& planes, const Segment& seg) {
+    int border = planes.refColor().c[channel_];
+    for (int x = 0; x < seg.size; x++) {
+        for (int y = 0; y < seg.size; y++) {
+            if (seg.x + x >= planes.width() || seg.y + y >= planes.height()) {
+                block_[x * seg.size + y] = border;
+            }
+        }
+    }
+}
+
+void ChannelPipeline::encodeSegment(Planes& planes, Planes& coefficients, Segment& seg) {
+    int n = seg.size;
+    size_t area = static_cast<size_t>(n) * n;
+    bool inside = insidePlanes(planes, seg);
+    ClampMethod cm = config_.clampMethod;
+
+    block_.resize(area);
+
+    // Predict, calculate residuals and quantize each row while it is hot
+    auto pred = predict(config_.predictionMethod, planes, channel_, seg);
+    for (int x = 0; x < n; x++) {
+        int32_t* row = block_.data() + x * n;
+        for (int y = 0; y < n; y++) {
+            row[y] = clampIn(cm, planes.get(channel_, seg.x + x, seg.y + y) - pred[x][y]);
+        }
+        if (quant_.active()) {
+            quant_.quantizeRow(row, n);
+        }
+    }
+    if (!inside) resetOutside(planes, seg);
+
+    // All-zero residuals skip coding entirely. Border segments under a float
+    // transform are excluded: padding leaks into their coefficients.
+    seg.skip = (inside || !transform_) && isZeroResidual(planes, seg);
+    if (seg.skip) {
+        finishSegment(planes, seg, pred);
+        return;
+    }
+
+    // Apply wavelet transform and scale to ints
+    if (transform_) {
+        coeffs_.resize(area);
+        for (size_t i = 0; i < area; i++) {
+            coeffs_[i] = block_[i] / 255.0;
+        }
+        transform_->forwardBatch(coeffs_.data(), n, 1);
+        if (compressor_) {
+            compressor_->compress(coeffs_.data(), area);
+        }
+        for (size_t i = 0; i < area; i++) {
+            block_[i] = static_cast<int>(std::round((coeffs_[i] * config_.transformScale) / static_cast<float>(n)));
+        }
+        if (!inside) resetOutside(planes, seg);
+    }
+
+    // Store coded values. Lifting is exact, so the residuals stay in the block
+    // and only a copy is transformed; border segments keep plain residuals.
+    const int32_t* coded = block_.data();
+    if (lifting_ && inside) {
+        lifted_.assign(block_.begin(), block_.end());
+        lifting_->forward(lifted_.data(), n);
+        coded = lifted_.data();
+    }
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            coefficients.set(channel_, seg.x + x, seg.y + y, coded[x * n + y]);
+        }
+    }
+
+    // Decompress now for next prediction
+    if (transform_) {
+        for (size_t i = 0; i < area; i++) {
+            coeffs_[i] = (n * block_[i]) / static_cast<float>(config_.transformScale);
+        }
+        transform_->reverseBatch(coeffs_.data(), n, 1);
+        for (size_t i = 0; i < area; i++) {
+            block_[i] = clamp(cm, static_cast<int>(std::round(coeffs_[i] * 255.0)));
+        }
+        if (!inside) resetOutside(planes, seg);
+    }
+
+    // Prediction only reads outside the segment, so it is reused as is
+    finishSegment(planes, seg, pred);
+}
+
+bool ChannelPipeline::isZeroResidual(const Planes& planes, const Segment& seg) const {
+    int w = std::min(seg.size, planes.width() - seg.x);
+    int h = std::min(seg.size, planes.height() - seg.y);
+    for (int x = 0; x < w; x++) {
+        for (int y = 0; y < h; y++) {
+            if (block_[x * seg.size + y] != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ChannelPipeline::finishSegment(Planes& planes, const Segment& seg, const std::vector<std::vector<int>>& pred) {
+    int n = seg.size;
+    for (int x = 0; x < n; x++) {
+        int32_t* row = block_.data() + x * n;
+        if (quant_.active()) {
+            quant_.dequantizeRow(row, n);
+        }
+        for (int y = 0; y < n; y++) {
+            planes.set(channel_, seg.x + x, seg.y + y, clampOut(config_.clampMethod, row[y] + pred[x][y]));
+        }
+    }
+}
+
+void ChannelPipeline::reconstructSegment(Planes& planes, Segment& seg) {
+    int n = seg.size;
+    if (seg.skip) {
+        block_.assign(static_cast<size_t>(n) * n, 0);
+    } else {
+        block_.resize(static_cast<size_t>(n) * n);
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                block_[x * n + y] = planes.get(channel_, seg.x + x, seg.y + y);
+            }
+        }
+    }
+
+    auto pred = predict(seg.predType, planes, channel_, seg);
+    finishSegment(planes, seg, pred);
+}
+
+void ChannelPipeline::reconstructReduced(const Planes& planes, Planes& reduced, const Segment& seg,
+                                         int factor, std::vector<int>& coverage) {
+    int n = seg.size;
+    int m = std::max(1, n / factor);
+    int gain = n / m;
+    size_t area = static_cast<size_t>(m) * m;
+
+    // Residual at the reduced scale. Every transform stores the low band of
+    // a block first, so the top-left m x m coefficients transform back to
+    // the block's approximation at m x m.
+    block_.assign(area, 0);
+    if (seg.skip) {
+        // Skipped segments reconstruct to the prediction alone
+    } else if (transform_) {
+        coeffs_.resize(area);
+        for (int x = 0; x < m; x++) {
+            for (int y = 0; y < m; y++) {
+                coeffs_[x * m + y] = (n * planes.get(channel_, seg.x + x, seg.y + y)) / static_cast<float>(config_.transformScale);
+            }
+        }
+        transform_->reverseBatch(coeffs_.data(), m, 1);
+        // Orthonormal low bands grow by the downscale factor in 2D
+        for (size_t i = 0; i < area; i++) {
+            block_[i] = clamp(config_.clampMethod, static_cast<int>(std::round(coeffs_[i] / gain * 255.0)));
+        }
+    } else if (lifting_ && insidePlanes(planes, seg)) {
+        // LeGall 5/3 low bands are local means already
+        for (int x = 0; x < m; x++) {
+            for (int y = 0; y < m; y++) {
+                block_[x * m + y] = planes.get(channel_, seg.x + x, seg.y + y);
+            }
+        }
+        lifting_->reverse(block_.data(), m);
+    } else {
+        // Plain residuals: mean of each gain x gain block inside the image
+        for (int x = 0; x < m; x++) {
+            for (int y = 0; y < m; y++) {
+                int sum = 0, count = 0;
+                for (int xx = x * gain; xx < (x + 1) * gain && seg.x + xx < planes.width(); xx++) {
+                    for (int yy = y * gain; yy < (y + 1) * gain && seg.y + yy < planes.height(); yy++) {
+                        sum += planes.get(channel_, seg.x + xx, seg.y + yy);
+                        count++;
+                    }
+                }
+                block_[x * m + y] = count ? sum / count : 0;
+            }
+        }
+    }
+
+    // Predict from the reduced neighbours, as the full decode does at full size
+    Segment scaled = seg;
+    scaled.x = seg.x / factor;
+    scaled.y = seg.y / factor;
+    scaled.size = m;
+    scaled.refX = static_cast<int16_t>(seg.refX / factor);
+    scaled.refY = static_cast<int16_t>(seg.refY / factor);
+    auto pred = predict(scaled.predType, reduced, channel_, scaled);
+
+    if (n >= factor) {
+        finishSegment(reduced, scaled, pred);
+        return;
+    }
+
+    // Smaller than a reduced pixel: fold into the pixel's running mean
+    int weight = std::min(n, planes.width() - seg.x) * std::min(n, planes.height() - seg.y);
+    if (weight <= 0 || scaled.x >= reduced.width() || scaled.y >= reduced.height()) {
+        return;
+    }
+    int r = quant_.active() ? quant_.dequantize(block_[0]) : block_[0];
+    int v = clampOut(config_.clampMethod, r + pred[0][0]);
+    int& covered = coverage[static_cast<size_t>(scaled.y) * reduced.width() + scaled.x];
+    int mean = covered ? reduced.get(channel_, scaled.x, scaled.y) : 0;
+    reduced.set(channel_, scaled.x, scaled.y, (mean * covered + v * weight) / (covered + weight));
+    covered += weight;
+}
+
+void ChannelPipeline::reverseTransform(Planes& planes, const std::vector<Segment>& segments) {
+    if (!transform_ && !lifting_) return;
+
+    // Each segment's inverse transform only reads its own decoded
+    // coefficients, so same-size segments are gathered into
+    // structure-of-arrays batches with lanes spanning blocks
+    std::vector<Segment> coded;
+    for (const auto& seg : segments) {
+        if (!seg.skip && (!lifting_ || insidePlanes(planes, seg))) {
+            coded.push_back(seg);
+        }
+    }
+
+    for (const auto& group : groupBySize(coded)) {
+        int n = group.first;
+        const auto& segs = group.second;
+        size_t maxCount = std::max<size_t>(1, MAX_BATCH_SAMPLES / (n * n));
+
+        for (size_t start = 0; start < segs.size(); start += maxCount) {
+            size_t count = std::min(maxCount, segs.size() - start);
+            size_t total = static_cast<size_t>(n) * n * count;
+
+            if (lifting_) {
+                block_.resize(total);
+            } else {
+                coeffs_.resize(total);
+            }
+
+            for (size_t b = 0; b < count; b++) {
+                const Segment& seg = *segs[start + b];
+                for (int x = 0; x < n; x++) {
+                    for (int y = 0; y < n; y++) {
+                        int v = planes.get(channel_, seg.x + x, seg.y + y);
+                        size_t i = (x * n + y) * count + b;
+                        if (lifting_) {
+                            block_[i] = v;
+                        } else {
+                            coeffs_[i] = (n * v) / static_cast<float>(config_.transformScale);
+                        }
+                    }
+                }
+            }
+
+            if (lifting_) {
+                lifting_->reverse(block_.data(), n, count);
+            } else {
+                transform_->reverseBatch(coeffs_.data(), n, count);
+            }
+
+            for (size_t b = 0; b < count; b++) {
+                const Segment& seg = *segs[start + b];
+                for (int x = 0; x < n; x++) {
+                    for (int y = 0; y < n; y++) {
+                        size_t i = (x * n + y) * count + b;
+                        int v = lifting_ ? block_[i]
+                                         : clamp(config_.clampMethod, static_cast<int>(std::round(coeffs_[i] * 255.0)));
+                        planes.set(channel_, seg.x + x, seg.y + y, v);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace glic
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "config.hpp"
+#include "planes.hpp"
+#include "quantization.hpp"
+#include "segment.hpp"
+#include "wavelet.hpp"
+#include <vector>
+#include <memory>
+#include <string>
+
+namespace glic {
+
+// Per-channel residual pipeline. Each segment is read from the planes once,
+// carried through subtract, quantize, transform and scale in a local block,
+// and written back once as coefficients and once as reconstruction.
+class ChannelPipeline {
+public:
+    ChannelPipeline(const ChannelConfig& config, int channel);
+
+    // Encode one segment: coded values go to `coefficients`, the decoder's
+    // reconstruction of the segment goes back to `planes`. Sets seg.skip
+    // when the quantized residual is all zero and nothing needs coding.
+    void encodeSegment(Planes& planes, Planes& coefficients, Segment& seg);
+
+    // Inverse transform every coded segment of the channel in place (batched)
+    void reverseTransform(Planes& planes, const std::vector<Segment>& segments);
+
+    // Dequantize and add the prediction back for one inverse-transformed
+    // segment; skipped segments reconstruct to the prediction alone
+    void reconstructSegment(Planes& planes, Segment& seg);
+
+    // Reconstruct a segment at 1/factor scale into `reduced`, from its
+    // decoded coefficients in `planes` (not inverse transformed). The
+    // residual comes from the transform's low band at that scale and the
+    // prediction is made on the reduced planes. Segments smaller than the
+    // factor are averaged into their reduced pixel, with `coverage`
+    // holding the area averaged so far per reduced pixel.
+    void reconstructReduced(const Planes& planes, Planes& reduced, const Segment& seg,
+                            int factor, std::vector<int>& coverage);
+
+    // Name of the transform in use, for logging
+    std::string transformName() const;
+
+private:
+    // Whether every in-image residual of the working block is zero
+    bool isZeroResidual(const Planes& planes, const Segment& seg) const;
+
+    // Dequantize a residual block, add the prediction and store the result
+    void finishSegment(Planes& planes, const Segment& seg, const std::vector<std::vector<int>>& pred);
+
+    // Positions past the image edge are never stored; reading them back
+    // yields the border color, so mirror that in the local block
+    void resetOutside(const Planes& planes, const Segment& seg);
+
+    const ChannelConfig& config_;
+    int channel_;
+    Quantizer quant_;
+
+    std::shared_ptr<Wavelet> wavelet_;
+    std::unique_ptr<WaveletTransform> transform_;
+    std::unique_ptr<MagnitudeCompressor> compressor_;
+    std::unique_ptr<LiftingTransform> lifting_;
+
+    // Working buffers reused across segments
+    std::vector<int32_t> block_;
+    std::vector<int32_t> lifted_;
+    std::vector<double> coeffs_;
+};
+
+// Whether a segment lies entirely inside the stored planes
+bool insidePlanes(const Planes& planes, const Segment& seg);
+
+} // namespace glic
@@ -115,6 +115,22 @@ std::vector<Color> Planes::toPixels(const Color* originalPixels) const {
     return pixels;
 }
 
+std::vector<Color> Planes::toPixels(int x0, int y0, int w, int h) const {
+    std::vector<Color> pixels(static_cast<size_t>(w) * h);
+    for (int x = 0; x < w; x++) {
+        for (int y = 0; y < h; y++) {
+            Color c = makeColor(
+                static_cast<uint8_t>(std::max(0, std::min(255, channels_[0][x0 + x][y0 + y]))),
+                static_cast<uint8_t>(std::max(0, std::min(255, channels_[1][x0 + x][y0 + y]))),
+                static_cast<uint8_t>(std::max(0, std::min(255, channels_[2][x0 + x][y0 + y]))),
+                255
+            );
+            pixels[static_cast<size_t>(y) * w + x] = fromColorSpace(c, cs_);
+        }
+    }
+    return pixels;
+}
+
 int Planes::get(int channel, int x, int y) const {
     if (x < 0 || x >= w_ || y < 0 || y >= h_) {
         return ref_.c[channel];
@@ -128,6 +144,15 @@ void Planes::set(int channel, int x, int y, int value) {
     }
 }
 
+void Planes::setBlock(int channel, const Segment& s, const int32_t* values) {
+    int w = std::min(s.size, w_ - s.x);
+    int h = std::min(s.size, h_ - s.y);
+    for (int x = 0; x < w; x++) {
+        const int32_t* src = values + static_cast<size_t>(x) * s.size;
+        std::copy(src, src + h, channels_[channel][s.x + x].begin() + s.y);
+    }
+}
+
 std::vector<std::vector<double>> Planes::getSegment(int channel, const Segment& s) const {
     std::vector<std::vector<double>> res(s.size, std::vector<double>(s.size));
     for (int x = 0; x < s.size; x++) {
@@ -33,6 +33,10 @@ public:
     // Convert to pixel array
     std::vector<Color> toPixels(const Color* originalPixels = nullptr) const;
 
+    // Convert only the rectangle at (x, y) of size w x h, which must lie
+    // inside the planes
+    std::vector<Color> toPixels(int x, int y, int w, int h) const;
+
     // Get/Set individual values
     int get(int channel, int x, int y) const;
     void set(int channel, int x, int y, int value);
@@ -43,6 +47,10 @@ public:
     // Set segment data from 2D array
     void setSegment(int channel, const Segment& s, const std::vector<std::vector<double>>& values, ClampMethod method);
 
+    // Store a block in segment order (x outer, y inner); positions past the
+    // image are dropped
+    void setBlock(int channel, const Segment& s, const int32_t* values);
+
     // Arithmetic operations on segments
     void subtract(int channel, const Segment& s, const std::vector<std::vector<int>>& values, ClampMethod method);
     void add(int channel, const Segment& s, const std::vector<std::vector<int>>& values, ClampMethod method);
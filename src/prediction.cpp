@@ -87,6 +87,12 @@ std::vector<std::vector<int>> predict(
     int channel,
     Segment& segment
 ) {
+    // Record the concrete predictor so reconstruction repeats it exactly;
+    // meta methods (SAD, BSAD, RANDOM) record their pick below
+    if (method >= PredictionMethod::NONE) {
+        segment.predType = method;
+    }
+
     switch (method) {
         case PredictionMethod::CORNER:
             return predCorner(planes, channel, segment);
@@ -593,4 +599,199 @@ std::vector<std::vector<int>> predEdge(const Planes& p, int ch, const Segment& s
     return res;
 }
 
+// ============================================================================
+// Prediction Data
+// ============================================================================
+
+namespace {
+
+// Bits of a stored predictor type; meta methods are never stored
+constexpr int PRED_TYPE_BITS = 5;
+static_assert(static_cast<int>(PredictionMethod::COUNT) <= (1 << PRED_TYPE_BITS), "predictor type field too narrow");
+
+// Exp-Golomb code: small values (run lengths, vector deltas) take few bits
+void writeExpGolomb(BitWriter& writer, uint32_t v) {
+    uint64_t u = uint64_t(v) + 1;
+    int len = 0;
+    while (u >> len) len++;
+    writer.writeBits(0, len - 1);
+    if (len > 32) {
+        writer.writeBit(true);
+        len--;
+    }
+    writer.writeBits(static_cast<uint32_t>(u), len);
+}
+
+uint32_t readExpGolomb(BitReader& reader) {
+    int zeros = reader.readUnary(32);
+    if (zeros >= 32) {
+        return reader.readBits(32);
+    }
+    return static_cast<uint32_t>(((uint64_t(1) << zeros) | reader.readBits(zeros)) - 1);
+}
+
+inline uint32_t zigzag(int v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int unzigzag(uint32_t u) {
+    return static_cast<int>((u >> 1) ^ (0u - (u & 1)));
+}
+
+} // anonymous namespace
+
+void writePredictionData(BitWriter& writer, const std::vector<Segment>& segments) {
+    // Predictor types as (type, run length) pairs
+    for (size_t i = 0; i < segments.size();) {
+        PredictionMethod type = segments[i].predType;
+        size_t run = 1;
+        while (i + run < segments.size() && segments[i + run].predType == type) {
+            run++;
+        }
+        writer.writeBits(static_cast<uint32_t>(static_cast<uint8_t>(type)), PRED_TYPE_BITS);
+        writeExpGolomb(writer, static_cast<uint32_t>(run - 1));
+        i += run;
+    }
+
+    // Parameters of the predictors that have any
+    int prevDx = 0, prevDy = 0;
+    for (const auto& seg : segments) {
+        if (seg.predType == PredictionMethod::REF) {
+            int dx = seg.refX - seg.x;
+            int dy = seg.refY - seg.y;
+            writeExpGolomb(writer, zigzag(dx - prevDx));
+            writeExpGolomb(writer, zigzag(dy - prevDy));
+            prevDx = dx;
+            prevDy = dy;
+        } else if (seg.predType == PredictionMethod::ANGLE) {
+            writer.writeBits(static_cast<uint32_t>(std::max(seg.refAngle, 0) % 3), 2);
+            int16_t angleVal = static_cast<int16_t>(0x7000 * seg.angle);
+            writer.writeBits(static_cast<uint16_t>(angleVal), 16);
+        }
+    }
+}
+
+void readPredictionData(BitReader& reader, std::vector<Segment>& segments, PredictionMethod defaultMethod) {
+    for (size_t i = 0; i < segments.size();) {
+        auto type = static_cast<PredictionMethod>(reader.readBits(PRED_TYPE_BITS));
+        size_t run = std::min<size_t>(uint64_t(readExpGolomb(reader)) + 1, segments.size() - i);
+        if (reader.overrun()) {
+            return;
+        }
+        if (type == PredictionMethod::NONE) {
+            type = defaultMethod;
+        }
+        for (size_t k = 0; k < run; k++) {
+            segments[i + k].predType = type;
+        }
+        i += run;
+    }
+
+    int prevDx = 0, prevDy = 0;
+    for (auto& seg : segments) {
+        if (seg.predType == PredictionMethod::REF) {
+            prevDx += unzigzag(readExpGolomb(reader));
+            prevDy += unzigzag(readExpGolomb(reader));
+            seg.refX = static_cast<int16_t>(seg.x + prevDx);
+            seg.refY = static_cast<int16_t>(seg.y + prevDy);
+        } else if (seg.predType == PredictionMethod::ANGLE) {
+            seg.refAngle = static_cast<int>(reader.readBits(2)) % 3;
+            seg.angle = static_cast<float>(static_cast<int16_t>(reader.readBits(16))) / 0x7000;
+        }
+        if (reader.overrun()) {
+            return;
+        }
+    }
+}
+
+// ============================================================================
+// Region Dependencies
+// ============================================================================
+
+std::vector<PixelRect> predictionFootprint(const Segment& s, int height) {
+    switch (s.predType) {
+        case PredictionMethod::REF:
+            return {{s.refX, s.refY, s.size, s.size}};
+        case PredictionMethod::ANGLE:
+            // Rays may meet the row above or the column left anywhere
+            return {{0, s.y - 1, s.x + s.size, 1}, {s.x - 1, 0, 1, height}};
+        default:
+            // Every other predictor reads at most two rows above and two
+            // columns left of the segment, corners included
+            return {{s.x - 2, s.y - 2, s.size + 2, 2}, {s.x - 2, s.y, 2, s.size}};
+    }
+}
+
+std::vector<RegionNeed> regionDependencies(
+    const std::vector<Segment>& segments,
+    const PixelRect& region,
+    int width,
+    int height
+) {
+    std::vector<RegionNeed> needs(segments.size(), RegionNeed::NONE);
+    if (segments.empty()) {
+        return needs;
+    }
+
+    // Segment index of every cell of the smallest segment size; quadtree
+    // segments are aligned to their size, so each cell has one owner
+    int cell = segments[0].size;
+    for (const auto& seg : segments) {
+        cell = std::min(cell, seg.size);
+    }
+    int gw = (width + cell - 1) / cell;
+    int gh = (height + cell - 1) / cell;
+    std::vector<int32_t> owner(static_cast<size_t>(gw) * gh, -1);
+    for (size_t i = 0; i < segments.size(); i++) {
+        const auto& seg = segments[i];
+        int x1 = std::min(seg.x + seg.size, width);
+        int y1 = std::min(seg.y + seg.size, height);
+        for (int cx = seg.x / cell; cx * cell < x1; cx++) {
+            for (int cy = seg.y / cell; cy * cell < y1; cy++) {
+                owner[static_cast<size_t>(cy) * gw + cx] = static_cast<int32_t>(i);
+            }
+        }
+    }
+
+    // Call f with the owner of each cell a rectangle touches in the image
+    auto visit = [&](const PixelRect& r, auto&& f) {
+        int x0 = std::max(r.x, 0);
+        int y0 = std::max(r.y, 0);
+        int x1 = std::min(r.x + r.w, width);
+        int y1 = std::min(r.y + r.h, height);
+        if (x0 >= x1 || y0 >= y1) return;
+        for (int cy = y0 / cell; cy <= (y1 - 1) / cell; cy++) {
+            for (int cx = x0 / cell; cx <= (x1 - 1) / cell; cx++) {
+                int32_t j = owner[static_cast<size_t>(cy) * gw + cx];
+                if (j >= 0) f(static_cast<size_t>(j));
+            }
+        }
+    };
+
+    // Segments are reconstructed in order, so a prediction sees earlier
+    // segments reconstructed and later ones still as residuals
+    std::vector<size_t> pending;
+    auto reconstruct = [&](size_t j) {
+        if (needs[j] != RegionNeed::RECONSTRUCT) {
+            needs[j] = RegionNeed::RECONSTRUCT;
+            pending.push_back(j);
+        }
+    };
+    visit(region, reconstruct);
+    while (!pending.empty()) {
+        size_t i = pending.back();
+        pending.pop_back();
+        for (const auto& r : predictionFootprint(segments[i], height)) {
+            visit(r, [&](size_t j) {
+                if (j < i) {
+                    reconstruct(j);
+                } else if (j > i && needs[j] == RegionNeed::NONE) {
+                    needs[j] = RegionNeed::TRANSFORM;
+                }
+            });
+        }
+    }
+    return needs;
+}
+
 } // namespace glic
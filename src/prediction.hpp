@@ -16,6 +16,40 @@ std::vector<std::vector<int>> predict(
     Segment& segment
 );
 
+// Per-segment prediction parameters, compactly: predictor types as runs,
+// then REF vectors (as deltas from the previous REF segment's) and ANGLE
+// parameters only for the segments that use them
+void writePredictionData(BitWriter& writer, const std::vector<Segment>& segments);
+
+// Read what writePredictionData wrote; NONE types fall back to defaultMethod
+void readPredictionData(BitReader& reader, std::vector<Segment>& segments, PredictionMethod defaultMethod);
+
+// Pixel rectangle [x, x + w) x [y, y + h)
+struct PixelRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+// Rectangles of the planes a segment's stored prediction reads; may reach
+// past the image, where reads give the border color
+std::vector<PixelRect> predictionFootprint(const Segment& s, int height);
+
+// What a decode of only `region` needs of each segment, in segment order
+enum class RegionNeed : uint8_t {
+    NONE = 0,
+    TRANSFORM = 1,   // Read as a residual by an earlier segment's prediction
+    RECONSTRUCT = 2  // In the region, or read by a later needed segment
+};
+
+std::vector<RegionNeed> regionDependencies(
+    const std::vector<Segment>& segments,
+    const PixelRect& region,
+    int width,
+    int height
+);
+
 // Calculate Sum of Absolute Differences
 int getSAD(
     const std::vector<std::vector<int>>& pred,
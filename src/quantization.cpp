@@ -1,22 +1,59 @@
 #include "quantization.hpp"
 #include <cmath>
+#include <algorithm>
 
 namespace glic {
 
+namespace {
+
+// Samples per vectorised chunk in the row forms
+constexpr size_t ROW_LANES = 8;
+
+} // anonymous namespace
+
+// round(v / val) = floor((4|v| + 2val) / 4val) with the sign restored; the
+// multiply-shift by recip_ equals that floor for numerators below 2^32 / 4val
+Quantizer::Quantizer(float val)
+    : q2_(static_cast<uint32_t>(std::max(0L, std::lround(val * 2.0f)))),
+      recip_(q2_ > 0 ? static_cast<uint32_t>((uint64_t(1) << 32) / (2 * q2_) + 1) : 0) {}
+
+// Rows are processed in fixed-width chunks: a constant trip count lets the
+// loops vectorise under the -O2 cost model, with a scalar tail
+void Quantizer::quantizeRow(int32_t* data, size_t count) const {
+    Quantizer q = *this;
+    size_t i = 0;
+    for (; i + ROW_LANES <= count; i += ROW_LANES) {
+        for (size_t k = 0; k < ROW_LANES; k++) {
+            data[i + k] = q.quantize(data[i + k]);
+        }
+    }
+    for (; i < count; i++) {
+        data[i] = q.quantize(data[i]);
+    }
+}
+
+void Quantizer::dequantizeRow(int32_t* data, size_t count) const {
+    Quantizer q = *this;
+    size_t i = 0;
+    for (; i + ROW_LANES <= count; i += ROW_LANES) {
+        for (size_t k = 0; k < ROW_LANES; k++) {
+            data[i + k] = q.dequantize(data[i + k]);
+        }
+    }
+    for (; i < count; i++) {
+        data[i] = q.dequantize(data[i]);
+    }
+}
+
 void quantize(Planes& planes, int channel, const Segment& segment, float val, bool forward) {
-    if (val <= 1) return;
+    Quantizer quant(val);
+    if (!quant.active()) return;
 
     for (int x = 0; x < segment.size; x++) {
         for (int y = 0; y < segment.size; y++) {
-            float col = static_cast<float>(planes.get(channel, x + segment.x, y + segment.y));
-
-            if (forward) {
-                col = col / val;
-            } else {
-                col = col * val;
-            }
-
-            planes.set(channel, x + segment.x, y + segment.y, static_cast<int>(std::round(col)));
+            int col = planes.get(channel, x + segment.x, y + segment.y);
+            col = forward ? quant.quantize(col) : quant.dequantize(col);
+            planes.set(channel, x + segment.x, y + segment.y, col);
         }
     }
 }
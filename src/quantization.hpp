@@ -2,12 +2,49 @@
 
 #include "planes.hpp"
 #include "segment.hpp"
+#include <cstddef>
+#include <cstdint>
 
 namespace glic {
 
 // Forward quantization (divide by val)
 void quantize(Planes& planes, int channel, const Segment& segment, float val, bool forward);
 
+// Integer quantizer for divisors in steps of 1/2 (as given by quantValue).
+// Rounds half away from zero like std::round on the float quotient, using a
+// precomputed fixed-point reciprocal instead of a division. Exact for
+// |v| < 2^20.
+class Quantizer {
+public:
+    explicit Quantizer(float val);
+
+    // Whether quantization changes anything (divisor above 1)
+    bool active() const { return q2_ > 2; }
+
+    // Divide by val, round to nearest
+    int quantize(int v) const {
+        int32_t s = v >> 31;
+        uint32_t a = static_cast<uint32_t>((v ^ s) - s);
+        uint32_t r = static_cast<uint32_t>((static_cast<uint64_t>(4 * a + q2_) * recip_) >> 32);
+        return static_cast<int>((r ^ s) - s);
+    }
+
+    // Multiply by val, round to nearest
+    int dequantize(int v) const {
+        int32_t p = v * static_cast<int32_t>(q2_);
+        int32_t t = p + 1 + 2 * (p >> 31);
+        return (t - (t >> 31)) >> 1;
+    }
+
+    // Row forms, branch-free so the compiler can vectorise them
+    void quantizeRow(int32_t* data, size_t count) const;
+    void dequantizeRow(int32_t* data, size_t count) const;
+
+private:
+    uint32_t q2_;     // 2 * val
+    uint32_t recip_;  // floor(2^32 / (4 * val)) + 1
+};
+
 // Helper to convert quantization value (0-255) to actual divisor
 inline float quantValue(int v) {
     return v / 2.0f;
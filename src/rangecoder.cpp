@@ -0,0 +1,56 @@
+#include "rangecoder.hpp"
+
+namespace glic {
+
+template <typename Sink>
+void BinaryEncoder<Sink>::encode(BitModel& model, bool bit) {
+    uint32_t bound = (range_ >> RC_PROB_BITS) * model.p;
+    if (!bit) {
+        range_ = bound;
+        model.p += (RC_PROB_ONE - model.p) >> RC_ADAPT_SHIFT;
+    } else {
+        low_ += bound;
+        range_ -= bound;
+        model.p -= model.p >> RC_ADAPT_SHIFT;
+    }
+    while (range_ < (1u << 24)) {
+        range_ <<= 8;
+        shiftLow();
+    }
+}
+
+template <typename Sink>
+void BinaryEncoder<Sink>::finish() {
+    for (int i = 0; i < 5; i++) {
+        shiftLow();
+    }
+}
+
+// Emit the top byte of low, holding back 0xFF bytes until a carry out of
+// low is known or ruled out
+template <typename Sink>
+void BinaryEncoder<Sink>::shiftLow() {
+    if (static_cast<uint32_t>(low_) < 0xFF000000u || (low_ >> 32) != 0) {
+        uint8_t carry = static_cast<uint8_t>(low_ >> 32);
+        uint8_t temp = cache_;
+        do {
+            writer_.writeByte(static_cast<uint8_t>(temp + carry));
+            temp = 0xFF;
+        } while (--cacheSize_ != 0);
+        cache_ = static_cast<uint8_t>(low_ >> 24);
+    }
+    cacheSize_++;
+    low_ = (low_ & 0x00FFFFFF) << 8;
+}
+
+template class BinaryEncoder<BitWriter>;
+template class BinaryEncoder<BitCounter>;
+
+BinaryDecoder::BinaryDecoder(BitReader& reader) : reader_(reader) {
+    // The encoder's first byte is always zero
+    for (int i = 0; i < 5; i++) {
+        code_ = (code_ << 8) | reader_.readByte();
+    }
+}
+
+} // namespace glic
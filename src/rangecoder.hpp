@@ -0,0 +1,71 @@
+#pragma once
+
+#include "bitio.hpp"
+#include <cstdint>
+
+namespace glic {
+
+// Adaptive binary range coder (LZMA style). Each BitModel holds the
+// probability of a zero bit and adapts after every bit coded with it, so
+// skewed flags cost well under a bit each.
+constexpr int RC_PROB_BITS = 11;
+constexpr uint32_t RC_PROB_ONE = 1u << RC_PROB_BITS;
+constexpr int RC_ADAPT_SHIFT = 5;
+
+struct BitModel {
+    uint16_t p = RC_PROB_ONE / 2;
+};
+
+// Codes bits into a BitWriter, or a BitCounter to cost them (both are
+// instantiated in rangecoder.cpp); finish() must be called once at the end
+template <typename Sink>
+class BinaryEncoder {
+public:
+    explicit BinaryEncoder(Sink& writer) : writer_(writer) {}
+
+    void encode(BitModel& model, bool bit);
+    void finish();
+
+private:
+    void shiftLow();
+
+    Sink& writer_;
+    uint64_t low_ = 0;
+    uint32_t range_ = 0xFFFFFFFF;
+    uint8_t cache_ = 0;
+    uint64_t cacheSize_ = 1;
+};
+
+// Decodes bits from a BitReader. Past the end of data the input reads as
+// zero bytes and the reader's overrun flag is set.
+class BinaryDecoder {
+public:
+    explicit BinaryDecoder(BitReader& reader);
+
+    bool decode(BitModel& model) {
+        uint32_t bound = (range_ >> RC_PROB_BITS) * model.p;
+        bool bit;
+        if (code_ < bound) {
+            range_ = bound;
+            model.p += (RC_PROB_ONE - model.p) >> RC_ADAPT_SHIFT;
+            bit = false;
+        } else {
+            code_ -= bound;
+            range_ -= bound;
+            model.p -= model.p >> RC_ADAPT_SHIFT;
+            bit = true;
+        }
+        if (range_ < (1u << 24)) {
+            range_ <<= 8;
+            code_ = (code_ << 8) | reader_.readByte();
+        }
+        return bit;
+    }
+
+private:
+    BitReader& reader_;
+    uint32_t range_ = 0xFFFFFFFF;
+    uint32_t code_ = 0;
+};
+
+} // namespace glic
@@ -0,0 +1,97 @@
+#include "rans.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace glic {
+
+RansTable RansTable::fromCounts(const std::vector<uint32_t>& counts) {
+    RansTable table;
+    uint64_t total = std::accumulate(counts.begin(), counts.end(), uint64_t(0));
+    table.freq_.assign(counts.size(), 0);
+    if (total == 0) {
+        return table;
+    }
+
+    int64_t sum = 0;
+    for (size_t s = 0; s < counts.size(); s++) {
+        if (counts[s] > 0) {
+            uint32_t f = static_cast<uint32_t>((uint64_t(counts[s]) * RANS_SCALE) / total);
+            table.freq_[s] = std::max<uint32_t>(1, f);
+            sum += table.freq_[s];
+        }
+    }
+
+    // Hand rounding slack to, or take it from, the most frequent symbols
+    std::vector<uint32_t> order(counts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return table.freq_[a] > table.freq_[b];
+    });
+    int64_t excess = sum - static_cast<int64_t>(RANS_SCALE);
+    if (excess < 0) {
+        table.freq_[order[0]] += static_cast<uint32_t>(-excess);
+    }
+    for (size_t i = 0; excess > 0 && i < order.size(); i++) {
+        uint32_t& f = table.freq_[order[i]];
+        uint32_t take = static_cast<uint32_t>(std::min<int64_t>(excess, f - 1));
+        f -= take;
+        excess -= take;
+    }
+
+    // Encoders only need the starts
+    table.buildStarts();
+    return table;
+}
+
+bool RansTable::setFrequencies(const std::vector<uint32_t>& freqs) {
+    uint64_t total = std::accumulate(freqs.begin(), freqs.end(), uint64_t(0));
+    if (total != RANS_SCALE) {
+        return false;
+    }
+    freq_ = freqs;
+    buildStarts();
+    slots_.assign(RANS_SCALE, 0);
+    for (size_t s = 0; s < freq_.size(); s++) {
+        std::fill(slots_.begin() + start_[s], slots_.begin() + start_[s] + freq_[s], static_cast<uint16_t>(s));
+    }
+    return true;
+}
+
+void RansTable::buildStarts() {
+    start_.assign(freq_.size(), 0);
+    uint32_t pos = 0;
+    for (size_t s = 0; s < freq_.size(); s++) {
+        start_[s] = pos;
+        pos += freq_[s];
+    }
+}
+
+void ransDecode(const uint8_t* data, size_t size, size_t count, const RansTable& table, uint32_t* symbols) {
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+    auto nextByte = [&]() -> uint32_t { return ptr < end ? *ptr++ : 0; };
+
+    uint32_t state[RANS_LANES];
+    for (int lane = 0; lane < RANS_LANES; lane++) {
+        uint32_t x = nextByte();
+        x |= nextByte() << 8;
+        x |= nextByte() << 16;
+        x |= nextByte() << 24;
+        state[lane] = x;
+    }
+
+    constexpr uint32_t mask = RANS_SCALE - 1;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t& x = state[i % RANS_LANES];
+        uint32_t s = table.symbolAt(x & mask);
+        symbols[i] = s;
+        x = table.freq(s) * (x >> RANS_SCALE_BITS) + (x & mask) - table.start(s);
+        while (x < RANS_LOW) {
+            x = (x << 8) | nextByte();
+            // Corrupt input can drain a state to zero; stop refilling then
+            if (x == 0 && ptr >= end) break;
+        }
+    }
+}
+
+} // namespace glic
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace glic {
+
+// Byte-wise rANS with a static frequency table and interleaved states.
+// Symbol i is coded with state i % RANS_LANES, so consecutive symbols
+// decode with independent dependency chains.
+constexpr int RANS_SCALE_BITS = 15;
+constexpr uint32_t RANS_SCALE = 1u << RANS_SCALE_BITS;
+constexpr int RANS_LANES = 4;
+// Lower bound of the normalized state interval [RANS_LOW, RANS_LOW << 8)
+constexpr uint32_t RANS_LOW = 1u << 23;
+
+// Symbol frequencies normalized to RANS_SCALE
+class RansTable {
+public:
+    RansTable() = default;
+
+    // Normalize raw symbol counts; every counted symbol keeps a nonzero share.
+    // The table can encode but has no slot lookup for decoding.
+    static RansTable fromCounts(const std::vector<uint32_t>& counts);
+
+    // Use already normalized frequencies (as stored in a stream). Returns
+    // false if they do not sum to RANS_SCALE.
+    bool setFrequencies(const std::vector<uint32_t>& freqs);
+
+    const std::vector<uint32_t>& frequencies() const { return freq_; }
+    size_t symbolCount() const { return freq_.size(); }
+
+    uint32_t freq(uint32_t s) const { return freq_[s]; }
+    uint32_t start(uint32_t s) const { return start_[s]; }
+    // Symbol owning a slot in [0, RANS_SCALE); set by setFrequencies()
+    uint32_t symbolAt(uint32_t slot) const { return slots_[slot]; }
+
+private:
+    void buildStarts();
+
+    std::vector<uint32_t> freq_;
+    std::vector<uint32_t> start_;
+    std::vector<uint16_t> slots_;
+};
+
+// Incremental encoder. Symbols are fed last to first with their index in
+// the block, which picks the lane, and bytes come out back to front through
+// emit(byte). Reversed, the bytes form a block ransDecode() reads.
+class RansEncoder {
+public:
+    RansEncoder() {
+        for (auto& x : state_) x = RANS_LOW;
+    }
+
+    // Symbol below table.symbolCount() with a nonzero frequency
+    template <typename Emit>
+    void put(size_t index, uint32_t symbol, const RansTable& table, Emit&& emit) {
+        uint32_t& x = state_[index % RANS_LANES];
+        uint32_t freq = table.freq(symbol);
+        uint32_t xMax = ((RANS_LOW >> RANS_SCALE_BITS) << 8) * freq;
+        while (x >= xMax) {
+            emit(static_cast<uint8_t>(x));
+            x >>= 8;
+        }
+        x = ((x / freq) << RANS_SCALE_BITS) + (x % freq) + table.start(symbol);
+    }
+
+    // Final states, lane 0 first once reversed, each little-endian
+    template <typename Emit>
+    void finish(Emit&& emit) {
+        for (int lane = RANS_LANES - 1; lane >= 0; lane--) {
+            emit(static_cast<uint8_t>(state_[lane] >> 24));
+            emit(static_cast<uint8_t>(state_[lane] >> 16));
+            emit(static_cast<uint8_t>(state_[lane] >> 8));
+            emit(static_cast<uint8_t>(state_[lane]));
+        }
+    }
+
+private:
+    uint32_t state_[RANS_LANES];
+};
+
+// Decode count symbols. Truncated input decodes as if padded with zeros.
+void ransDecode(const uint8_t* data, size_t size, size_t count, const RansTable& table, uint32_t* symbols);
+
+} // namespace glic
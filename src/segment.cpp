@@ -1,5 +1,6 @@
 #include "segment.hpp"
 #include "planes.hpp"
+#include "rangecoder.hpp"
 #include <cmath>
 #include <random>
 #include <sstream>
@@ -15,12 +16,51 @@ std::mt19937& getRng() {
     return rng;
 }
 
+// Depth levels with their own split models; deeper nodes share the last
+constexpr int SPLIT_DEPTHS = 16;
+
+// Children of a split node in coding order, in units of half its size
+constexpr int CHILD_ORDER[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+
+// Split flag models indexed by node depth and by how many of the left and
+// upper neighbours were split below that depth. Quadtree order codes both
+// neighbours before the node, so the decoder sees the same context.
+class SplitContext {
+public:
+    SplitContext(int width, int height)
+        : width_(width), height_(height),
+          leafDepth_(static_cast<size_t>(width) * height, 0),
+          models_(SPLIT_DEPTHS * 3) {}
+
+    BitModel& model(int x, int y, int depth) {
+        int split = (x > 0 && leafDepth_[static_cast<size_t>(x - 1) * height_ + y] > depth)
+                  + (y > 0 && leafDepth_[static_cast<size_t>(x) * height_ + y - 1] > depth);
+        return models_[std::min(depth, SPLIT_DEPTHS - 1) * 3 + split];
+    }
+
+    void markLeaf(int x, int y, int size, int depth) {
+        int w = std::min(size, width_ - x);
+        int h = std::min(size, height_ - y);
+        uint8_t d = static_cast<uint8_t>(std::min(depth, 255));
+        for (int i = 0; i < w; i++) {
+            auto col = leafDepth_.begin() + static_cast<size_t>(x + i) * height_ + y;
+            std::fill(col, col + h, d);
+        }
+    }
+
+private:
+    int width_, height_;
+    std::vector<uint8_t> leafDepth_;
+    std::vector<BitModel> models_;
+};
+
 void segmentRecursive(
-    BitWriter& writer,
+    BinaryEncoder<BitWriter>& coder,
+    SplitContext& context,
     std::vector<Segment>& segments,
     const Planes& planes,
     int channel,
-    int x, int y, int size,
+    int x, int y, int size, int depth,
     int minSize, int maxSize,
     float threshold
 ) {
@@ -29,14 +69,15 @@ void segmentRecursive(
     float currStdDev = calcStdDev(planes, channel, x, y, size);
 
     if (size > maxSize || (size > minSize && currStdDev > threshold)) {
-        writer.writeBoolean(true);
+        coder.encode(context.model(x, y, depth), true);
         int mid = size / 2;
-        segmentRecursive(writer, segments, planes, channel, x, y, mid, minSize, maxSize, threshold);
-        segmentRecursive(writer, segments, planes, channel, x + mid, y, mid, minSize, maxSize, threshold);
-        segmentRecursive(writer, segments, planes, channel, x, y + mid, mid, minSize, maxSize, threshold);
-        segmentRecursive(writer, segments, planes, channel, x + mid, y + mid, mid, minSize, maxSize, threshold);
+        for (const auto& child : CHILD_ORDER) {
+            segmentRecursive(coder, context, segments, planes, channel, x + child[0] * mid, y + child[1] * mid, mid,
+                             depth + 1, minSize, maxSize, threshold);
+        }
     } else {
-        writer.writeBoolean(false);
+        coder.encode(context.model(x, y, depth), false);
+        context.markLeaf(x, y, size, depth);
         Segment seg;
         seg.x = x;
         seg.y = y;
@@ -45,6 +86,7 @@ void segmentRecursive(
     }
 }
 
+// Raw split flags, one bit per node (version 1 streams)
 void readSegmentRecursive(
     BitReader& reader,
     std::vector<Segment>& segments,
@@ -53,12 +95,8 @@ void readSegmentRecursive(
 ) {
     if (x >= width || y >= height) return;
 
-    bool decision;
-    try {
-        decision = reader.readBoolean();
-    } catch (...) {
-        decision = false;
-    }
+    // Past the end of data this reads false, ending the split
+    bool decision = reader.readBoolean();
 
     if (decision && size > 2) {
         int mid = size / 2;
@@ -97,7 +135,10 @@ std::vector<Segment> makeSegmentation(
     minSize = std::max(1, minSize);
     maxSize = std::min(512, maxSize);
 
-    segmentRecursive(writer, segments, planes, channel, 0, 0, startSize, minSize, maxSize, threshold);
+    BinaryEncoder coder(writer);
+    SplitContext context(planes.width(), planes.height());
+    segmentRecursive(coder, context, segments, planes, channel, 0, 0, startSize, 0, minSize, maxSize, threshold);
+    coder.finish();
 
     return segments;
 }
@@ -107,16 +148,72 @@ std::vector<Segment> readSegmentation(
     int paddedWidth,
     int paddedHeight,
     int width,
-    int height
+    int height,
+    bool rangeCoded
 ) {
     std::vector<Segment> segments;
 
     int startSize = std::max(paddedWidth, paddedHeight);
-    readSegmentRecursive(reader, segments, 0, 0, startSize, width, height);
+    if (!rangeCoded) {
+        readSegmentRecursive(reader, segments, 0, 0, startSize, width, height);
+        return segments;
+    }
+
+    // Walk the tree without recursion from a table holding, for each open
+    // split node, its position, child size and the child being visited.
+    // Splits stop at size 2, so a power-of-two start size bounds the depth.
+    struct Level {
+        int x, y, mid, child;
+    };
+    Level levels[32];
+    int depth = 0;
+    int x = 0, y = 0, size = startSize;
+
+    BinaryDecoder coder(reader);
+    SplitContext context(width, height);
+    while (true) {
+        if (x < width && y < height) {
+            bool split = coder.decode(context.model(x, y, depth));
+            if (split && size > 2) {
+                levels[depth++] = {x, y, size / 2, -1};
+            } else {
+                context.markLeaf(x, y, size, depth);
+                Segment seg;
+                seg.x = x;
+                seg.y = y;
+                seg.size = size;
+                segments.push_back(seg);
+            }
+        }
+
+        // Next child of the deepest node with children left
+        while (depth > 0 && levels[depth - 1].child == 3) {
+            depth--;
+        }
+        if (depth == 0) {
+            break;
+        }
+        Level& open = levels[depth - 1];
+        open.child++;
+        x = open.x + CHILD_ORDER[open.child][0] * open.mid;
+        y = open.y + CHILD_ORDER[open.child][1] * open.mid;
+        size = open.mid;
+    }
 
     return segments;
 }
 
+std::vector<Segment> codedSegments(const std::vector<Segment>& segments) {
+    std::vector<Segment> coded;
+    coded.reserve(segments.size());
+    for (const auto& seg : segments) {
+        if (!seg.skip) {
+            coded.push_back(seg);
+        }
+    }
+    return coded;
+}
+
 float calcStdDev(const Planes& planes, int channel, int x, int y, int size) {
     int limit = std::max(static_cast<int>(0.1f * size * size), 4);
 
@@ -22,10 +22,14 @@ struct Segment {
     int16_t refX = std::numeric_limits<int16_t>::max();
     int16_t refY = std::numeric_limits<int16_t>::max();
 
+    // Residual is all zero; no coded data, reconstructs to the prediction
+    bool skip = false;
+
     std::string toString() const;
 };
 
-// Create segmentation using quad-tree decomposition
+// Create segmentation using quad-tree decomposition; split flags are
+// range coded with context models
 std::vector<Segment> makeSegmentation(
     BitWriter& writer,
     const Planes& planes,
@@ -35,15 +39,20 @@ std::vector<Segment> makeSegmentation(
     float threshold
 );
 
-// Read segmentation from bit stream
+// Read segmentation from bit stream; rangeCoded is false for version 1
+// streams, which store one raw bit per split flag
 std::vector<Segment> readSegmentation(
     BitReader& reader,
     int paddedWidth,
     int paddedHeight,
     int width,
-    int height
+    int height,
+    bool rangeCoded
 );
 
+// Segments that carry coded residual data (not skipped)
+std::vector<Segment> codedSegments(const std::vector<Segment>& segments);
+
 // Calculate standard deviation for segmentation decision
 float calcStdDev(const Planes& planes, int channel, int x, int y, int size);
 
@@ -201,266 +201,297 @@ std::unique_ptr<WaveletTransform> createTransform(TransformType type, std::share
     }
 }
 
-// FastWaveletTransform implementation
-FastWaveletTransform::FastWaveletTransform(std::shared_ptr<Wavelet> wavelet)
-    : wavelet_(wavelet) {}
-
-std::vector<double> FastWaveletTransform::forward1D(const std::vector<double>& data) {
-    size_t n = data.size();
-    if (n < 2) return data;
-
-    std::vector<double> result(n);
-    const auto& lpd = wavelet_->getLowPassDecomposition();
-    const auto& hpd = wavelet_->getHighPassDecomposition();
-    size_t filterLen = lpd.size();
-
-    size_t half = n / 2;
+namespace {
+
+// One analysis step over a packet of len samples for count blocks in lockstep.
+// Consecutive samples are srcStride/dstStride apart; the blocks of one sample
+// are contiguous, so the inner loop runs across blocks.
+void analyzeBatch(const double* src, size_t srcStride, double* dst, size_t dstStride,
+                  size_t len, size_t count,
+                  const std::vector<double>& lpd, const std::vector<double>& hpd) {
+    size_t half = len / 2;
     for (size_t i = 0; i < half; i++) {
-        double low = 0, high = 0;
-        for (size_t j = 0; j < filterLen; j++) {
-            size_t idx = (2 * i + j) % n;
-            low += lpd[j] * data[idx];
-            high += hpd[j] * data[idx];
+        double* low = dst + i * dstStride;
+        double* high = dst + (half + i) * dstStride;
+        std::fill(low, low + count, 0.0);
+        std::fill(high, high + count, 0.0);
+        for (size_t j = 0; j < lpd.size(); j++) {
+            const double* s = src + ((2 * i + j) % len) * srcStride;
+            double lc = lpd[j];
+            double hc = hpd[j];
+            for (size_t b = 0; b < count; b++) {
+                low[b] += lc * s[b];
+                high[b] += hc * s[b];
+            }
         }
-        result[i] = low;
-        result[half + i] = high;
     }
-    return result;
 }
 
-std::vector<double> FastWaveletTransform::reverse1D(const std::vector<double>& data) {
-    size_t n = data.size();
-    if (n < 2) return data;
-
-    std::vector<double> result(n, 0);
-    const auto& lpr = wavelet_->getLowPassReconstruction();
-    const auto& hpr = wavelet_->getHighPassReconstruction();
-    size_t filterLen = lpr.size();
-
-    size_t half = n / 2;
+// Inverse of analyzeBatch
+void synthesizeBatch(const double* src, size_t srcStride, double* dst, size_t dstStride,
+                     size_t len, size_t count,
+                     const std::vector<double>& lpr, const std::vector<double>& hpr) {
+    size_t half = len / 2;
+    for (size_t k = 0; k < len; k++) {
+        std::fill(dst + k * dstStride, dst + k * dstStride + count, 0.0);
+    }
     for (size_t i = 0; i < half; i++) {
-        for (size_t j = 0; j < filterLen; j++) {
-            size_t idx = (2 * i + j) % n;
-            result[idx] += lpr[j] * data[i] + hpr[j] * data[half + i];
+        const double* low = src + i * srcStride;
+        const double* high = src + (half + i) * srcStride;
+        for (size_t j = 0; j < lpr.size(); j++) {
+            double* d = dst + ((2 * i + j) % len) * dstStride;
+            double lc = lpr[j];
+            double hc = hpr[j];
+            for (size_t b = 0; b < count; b++) {
+                d[b] += lc * low[b] + hc * high[b];
+            }
         }
     }
-    return result;
 }
 
-std::vector<std::vector<double>> FastWaveletTransform::forward(const std::vector<std::vector<double>>& data) {
-    size_t rows = data.size();
-    if (rows == 0) return data;
-    size_t cols = data[0].size();
+// Copy len samples of count blocks between strided lines
+void copyBatch(const double* src, size_t srcStride, double* dst, size_t dstStride,
+               size_t len, size_t count) {
+    for (size_t k = 0; k < len; k++) {
+        std::copy(src + k * srcStride, src + k * srcStride + count, dst + k * dstStride);
+    }
+}
+
+} // anonymous namespace
+
+// FastWaveletTransform implementation
+FastWaveletTransform::FastWaveletTransform(std::shared_ptr<Wavelet> wavelet)
+    : wavelet_(wavelet) {}
+
+void FastWaveletTransform::forwardBatch(double* data, size_t n, size_t count) {
+    const auto& lpd = wavelet_->getLowPassDecomposition();
+    const auto& hpd = wavelet_->getHighPassDecomposition();
+    size_t rowStride = count;
+    size_t colStride = n * count;
 
-    auto result = data;
+    scratch_.resize(n * count);
 
     // Transform rows
-    for (size_t i = 0; i < rows; i++) {
-        size_t len = cols;
-        while (len >= 2) {
-            std::vector<double> temp(result[i].begin(), result[i].begin() + len);
-            auto transformed = forward1D(temp);
-            std::copy(transformed.begin(), transformed.end(), result[i].begin());
-            len /= 2;
+    for (size_t x = 0; x < n; x++) {
+        double* line = data + x * colStride;
+        for (size_t len = n; len >= 2; len /= 2) {
+            analyzeBatch(line, rowStride, scratch_.data(), count, len, count, lpd, hpd);
+            copyBatch(scratch_.data(), count, line, rowStride, len, count);
         }
     }
 
     // Transform columns
-    for (size_t j = 0; j < cols; j++) {
-        size_t len = rows;
-        while (len >= 2) {
-            std::vector<double> temp(len);
-            for (size_t i = 0; i < len; i++) {
-                temp[i] = result[i][j];
-            }
-            auto transformed = forward1D(temp);
-            for (size_t i = 0; i < len; i++) {
-                result[i][j] = transformed[i];
-            }
-            len /= 2;
+    for (size_t y = 0; y < n; y++) {
+        double* line = data + y * rowStride;
+        for (size_t len = n; len >= 2; len /= 2) {
+            analyzeBatch(line, colStride, scratch_.data(), count, len, count, lpd, hpd);
+            copyBatch(scratch_.data(), count, line, colStride, len, count);
         }
     }
-
-    return result;
 }
 
-std::vector<std::vector<double>> FastWaveletTransform::reverse(const std::vector<std::vector<double>>& data) {
-    size_t rows = data.size();
-    if (rows == 0) return data;
-    size_t cols = data[0].size();
+void FastWaveletTransform::reverseBatch(double* data, size_t n, size_t count) {
+    const auto& lpr = wavelet_->getLowPassReconstruction();
+    const auto& hpr = wavelet_->getHighPassReconstruction();
+    size_t rowStride = count;
+    size_t colStride = n * count;
 
-    auto result = data;
+    scratch_.resize(n * count);
 
     // Inverse transform columns
-    for (size_t j = 0; j < cols; j++) {
-        size_t len = 2;
-        while (len <= rows) {
-            std::vector<double> temp(len);
-            for (size_t i = 0; i < len; i++) {
-                temp[i] = result[i][j];
-            }
-            auto transformed = reverse1D(temp);
-            for (size_t i = 0; i < len; i++) {
-                result[i][j] = transformed[i];
-            }
-            len *= 2;
+    for (size_t y = 0; y < n; y++) {
+        double* line = data + y * rowStride;
+        for (size_t len = 2; len <= n; len *= 2) {
+            synthesizeBatch(line, colStride, scratch_.data(), count, len, count, lpr, hpr);
+            copyBatch(scratch_.data(), count, line, colStride, len, count);
         }
     }
 
     // Inverse transform rows
-    for (size_t i = 0; i < rows; i++) {
-        size_t len = 2;
-        while (len <= cols) {
-            std::vector<double> temp(result[i].begin(), result[i].begin() + len);
-            auto transformed = reverse1D(temp);
-            std::copy(transformed.begin(), transformed.end(), result[i].begin());
-            len *= 2;
+    for (size_t x = 0; x < n; x++) {
+        double* line = data + x * colStride;
+        for (size_t len = 2; len <= n; len *= 2) {
+            synthesizeBatch(line, rowStride, scratch_.data(), count, len, count, lpr, hpr);
+            copyBatch(scratch_.data(), count, line, rowStride, len, count);
         }
     }
-
-    return result;
 }
 
 // WaveletPacketTransform implementation
 WaveletPacketTransform::WaveletPacketTransform(std::shared_ptr<Wavelet> wavelet)
     : wavelet_(wavelet) {}
 
-std::vector<double> WaveletPacketTransform::forward1D(const std::vector<double>& data, int level) {
-    if (level <= 0 || data.size() < 2) return data;
-
+void WaveletPacketTransform::forwardBatch(double* data, size_t n, size_t count) {
     const auto& lpd = wavelet_->getLowPassDecomposition();
     const auto& hpd = wavelet_->getHighPassDecomposition();
-    size_t n = data.size();
-    size_t filterLen = lpd.size();
-
-    std::vector<double> result(n);
-    size_t half = n / 2;
-
-    for (size_t i = 0; i < half; i++) {
-        double low = 0, high = 0;
-        for (size_t j = 0; j < filterLen; j++) {
-            size_t idx = (2 * i + j) % n;
-            low += lpd[j] * data[idx];
-            high += hpd[j] * data[idx];
+    scratch_.resize(n * count);
+    work_.resize(n * count);
+
+    // Rows, then columns; each line is split into packets level by level
+    for (int pass = 0; pass < 2; pass++) {
+        size_t stride = (pass == 0) ? count : n * count;
+        size_t lineStep = (pass == 0) ? n * count : count;
+        for (size_t k = 0; k < n; k++) {
+            double* line = data + k * lineStep;
+            copyBatch(line, stride, scratch_.data(), count, n, count);
+            for (size_t len = n; len >= 2; len /= 2) {
+                for (size_t p = 0; p < n; p += len) {
+                    analyzeBatch(scratch_.data() + p * count, count, work_.data() + p * count, count,
+                                 len, count, lpd, hpd);
+                }
+                std::swap(scratch_, work_);
+            }
+            copyBatch(scratch_.data(), count, line, stride, n, count);
         }
-        result[i] = low;
-        result[half + i] = high;
     }
-
-    // Recursively transform both halves
-    std::vector<double> lowPart(result.begin(), result.begin() + half);
-    std::vector<double> highPart(result.begin() + half, result.end());
-
-    lowPart = forward1D(lowPart, level - 1);
-    highPart = forward1D(highPart, level - 1);
-
-    std::copy(lowPart.begin(), lowPart.end(), result.begin());
-    std::copy(highPart.begin(), highPart.end(), result.begin() + half);
-
-    return result;
 }
 
-std::vector<double> WaveletPacketTransform::reverse1D(const std::vector<double>& data, int level) {
-    if (level <= 0 || data.size() < 2) return data;
-
-    size_t n = data.size();
-    size_t half = n / 2;
-
-    // First reverse the recursive parts
-    std::vector<double> lowPart(data.begin(), data.begin() + half);
-    std::vector<double> highPart(data.begin() + half, data.end());
-
-    lowPart = reverse1D(lowPart, level - 1);
-    highPart = reverse1D(highPart, level - 1);
-
+void WaveletPacketTransform::reverseBatch(double* data, size_t n, size_t count) {
     const auto& lpr = wavelet_->getLowPassReconstruction();
     const auto& hpr = wavelet_->getHighPassReconstruction();
-    size_t filterLen = lpr.size();
+    scratch_.resize(n * count);
+    work_.resize(n * count);
+
+    // Columns, then rows; packets are merged from the finest level up
+    for (int pass = 0; pass < 2; pass++) {
+        size_t stride = (pass == 0) ? n * count : count;
+        size_t lineStep = (pass == 0) ? count : n * count;
+        for (size_t k = 0; k < n; k++) {
+            double* line = data + k * lineStep;
+            copyBatch(line, stride, scratch_.data(), count, n, count);
+            for (size_t len = 2; len <= n; len *= 2) {
+                for (size_t p = 0; p < n; p += len) {
+                    synthesizeBatch(scratch_.data() + p * count, count, work_.data() + p * count, count,
+                                    len, count, lpr, hpr);
+                }
+                std::swap(scratch_, work_);
+            }
+            copyBatch(scratch_.data(), count, line, stride, n, count);
+        }
+    }
+}
+
+// LiftingTransform implementation
+namespace {
 
-    std::vector<double> result(n, 0);
+// One 5/3 analysis level along the line index: lines [0, len) of `width`
+// ints each become [s0..s(h-1), d0..d(h-1)], with symmetric extension at the
+// borders. Inner loops run across the width, so they vectorise.
+void liftForward(int32_t* lines, size_t len, size_t width, int32_t* scratch) {
+    size_t half = len / 2;
+    int32_t* s = scratch;
+    int32_t* d = scratch + half * width;
 
+    // Predict: d[i] = x[2i+1] - floor((x[2i] + x[2i+2]) / 2)
     for (size_t i = 0; i < half; i++) {
-        for (size_t j = 0; j < filterLen; j++) {
-            size_t idx = (2 * i + j) % n;
-            result[idx] += lpr[j] * lowPart[i] + hpr[j] * highPart[i];
+        const int32_t* e = lines + 2 * i * width;
+        const int32_t* o = e + width;
+        const int32_t* en = (2 * i + 2 < len) ? e + 2 * width : e;
+        int32_t* di = d + i * width;
+        for (size_t b = 0; b < width; b++) {
+            di[b] = o[b] - ((e[b] + en[b]) >> 1);
         }
     }
 
-    return result;
-}
-
-std::vector<std::vector<double>> WaveletPacketTransform::forward(const std::vector<std::vector<double>>& data) {
-    size_t rows = data.size();
-    if (rows == 0) return data;
-    size_t cols = data[0].size();
+    // Update: s[i] = x[2i] + floor((d[i-1] + d[i] + 2) / 4)
+    for (size_t i = 0; i < half; i++) {
+        const int32_t* e = lines + 2 * i * width;
+        const int32_t* di = d + i * width;
+        const int32_t* dp = (i > 0) ? di - width : di;
+        int32_t* si = s + i * width;
+        for (size_t b = 0; b < width; b++) {
+            si[b] = e[b] + ((dp[b] + di[b] + 2) >> 2);
+        }
+    }
 
-    int levels = static_cast<int>(std::log2(std::min(rows, cols)));
+    std::copy(scratch, scratch + len * width, lines);
+}
 
-    auto result = data;
+// Exact inverse of liftForward
+void liftReverse(int32_t* lines, size_t len, size_t width, int32_t* scratch) {
+    size_t half = len / 2;
+    const int32_t* s = lines;
+    const int32_t* d = lines + half * width;
 
-    // Transform rows
-    for (size_t i = 0; i < rows; i++) {
-        result[i] = forward1D(result[i], levels);
+    // Undo update into the even lines
+    for (size_t i = 0; i < half; i++) {
+        const int32_t* di = d + i * width;
+        const int32_t* dp = (i > 0) ? di - width : di;
+        const int32_t* si = s + i * width;
+        int32_t* e = scratch + 2 * i * width;
+        for (size_t b = 0; b < width; b++) {
+            e[b] = si[b] - ((dp[b] + di[b] + 2) >> 2);
+        }
     }
 
-    // Transform columns
-    for (size_t j = 0; j < cols; j++) {
-        std::vector<double> col(rows);
-        for (size_t i = 0; i < rows; i++) {
-            col[i] = result[i][j];
-        }
-        col = forward1D(col, levels);
-        for (size_t i = 0; i < rows; i++) {
-            result[i][j] = col[i];
+    // Undo predict into the odd lines
+    for (size_t i = 0; i < half; i++) {
+        const int32_t* e = scratch + 2 * i * width;
+        const int32_t* en = (2 * i + 2 < len) ? e + 2 * width : e;
+        const int32_t* di = d + i * width;
+        int32_t* o = scratch + (2 * i + 1) * width;
+        for (size_t b = 0; b < width; b++) {
+            o[b] = di[b] + ((e[b] + en[b]) >> 1);
         }
     }
 
-    return result;
+    std::copy(scratch, scratch + len * width, lines);
 }
 
-std::vector<std::vector<double>> WaveletPacketTransform::reverse(const std::vector<std::vector<double>>& data) {
-    size_t rows = data.size();
-    if (rows == 0) return data;
-    size_t cols = data[0].size();
+} // anonymous namespace
 
-    int levels = static_cast<int>(std::log2(std::min(rows, cols)));
+void LiftingTransform::transpose(int32_t* data, size_t n, size_t count) {
+    for (size_t x = 0; x < n; x++) {
+        for (size_t y = 0; y < n; y++) {
+            std::copy(data + (x * n + y) * count, data + (x * n + y + 1) * count,
+                      scratch_.data() + (y * n + x) * count);
+        }
+    }
+    std::copy(scratch_.begin(), scratch_.begin() + n * n * count, data);
+}
 
-    auto result = data;
+void LiftingTransform::forward(int32_t* data, size_t n, size_t count) {
+    size_t width = n * count;
+    scratch_.resize(n * width);
 
-    // Inverse transform columns
-    for (size_t j = 0; j < cols; j++) {
-        std::vector<double> col(rows);
-        for (size_t i = 0; i < rows; i++) {
-            col[i] = result[i][j];
-        }
-        col = reverse1D(col, levels);
-        for (size_t i = 0; i < rows; i++) {
-            result[i][j] = col[i];
-        }
+    // Along x, every y and block in one lane
+    for (size_t len = n; len >= 2; len /= 2) {
+        liftForward(data, len, width, scratch_.data());
     }
 
-    // Inverse transform rows
-    for (size_t i = 0; i < rows; i++) {
-        result[i] = reverse1D(result[i], levels);
+    // Along y
+    transpose(data, n, count);
+    for (size_t len = n; len >= 2; len /= 2) {
+        liftForward(data, len, width, scratch_.data());
     }
+    transpose(data, n, count);
+}
+
+void LiftingTransform::reverse(int32_t* data, size_t n, size_t count) {
+    size_t width = n * count;
+    scratch_.resize(n * width);
 
-    return result;
+    transpose(data, n, count);
+    for (size_t len = 2; len <= n; len *= 2) {
+        liftReverse(data, len, width, scratch_.data());
+    }
+    transpose(data, n, count);
+
+    for (size_t len = 2; len <= n; len *= 2) {
+        liftReverse(data, len, width, scratch_.data());
+    }
 }
 
 // MagnitudeCompressor implementation
 MagnitudeCompressor::MagnitudeCompressor(double threshold)
     : threshold_(threshold) {}
 
-std::vector<std::vector<double>> MagnitudeCompressor::compress(const std::vector<std::vector<double>>& data) {
-    auto result = data;
-    for (auto& row : result) {
-        for (auto& val : row) {
-            if (std::abs(val) < threshold_) {
-                val = 0;
-            }
+void MagnitudeCompressor::compress(double* data, size_t size) const {
+    for (size_t i = 0; i < size; i++) {
+        if (std::abs(data[i]) < threshold_) {
+            data[i] = 0;
         }
     }
-    return result;
 }
 
 } // namespace glic
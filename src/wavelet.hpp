@@ -26,11 +26,11 @@ class WaveletTransform {
 public:
     virtual ~WaveletTransform() = default;
 
-    // 2D forward transform
-    virtual std::vector<std::vector<double>> forward(const std::vector<std::vector<double>>& data) = 0;
-
-    // 2D reverse transform
-    virtual std::vector<std::vector<double>> reverse(const std::vector<std::vector<double>>& data) = 0;
+    // Batched 2D transforms over `count` square blocks of side n, stored
+    // structure-of-arrays: sample [x][y] of block b is data[(x * n + y) * count + b].
+    // A single block is count = 1.
+    virtual void forwardBatch(double* data, size_t n, size_t count) = 0;
+    virtual void reverseBatch(double* data, size_t n, size_t count) = 0;
 
     virtual std::string getName() const = 0;
 };
@@ -40,15 +40,15 @@ class FastWaveletTransform : public WaveletTransform {
 public:
     explicit FastWaveletTransform(std::shared_ptr<Wavelet> wavelet);
 
-    std::vector<std::vector<double>> forward(const std::vector<std::vector<double>>& data) override;
-    std::vector<std::vector<double>> reverse(const std::vector<std::vector<double>>& data) override;
+    void forwardBatch(double* data, size_t n, size_t count) override;
+    void reverseBatch(double* data, size_t n, size_t count) override;
     std::string getName() const override { return "FWT"; }
 
 private:
-    std::vector<double> forward1D(const std::vector<double>& data);
-    std::vector<double> reverse1D(const std::vector<double>& data);
-
     std::shared_ptr<Wavelet> wavelet_;
+
+    // Line buffer reused across calls
+    std::vector<double> scratch_;
 };
 
 // Wavelet Packet Transform
@@ -56,23 +56,46 @@ class WaveletPacketTransform : public WaveletTransform {
 public:
     explicit WaveletPacketTransform(std::shared_ptr<Wavelet> wavelet);
 
-    std::vector<std::vector<double>> forward(const std::vector<std::vector<double>>& data) override;
-    std::vector<std::vector<double>> reverse(const std::vector<std::vector<double>>& data) override;
+    void forwardBatch(double* data, size_t n, size_t count) override;
+    void reverseBatch(double* data, size_t n, size_t count) override;
     std::string getName() const override { return "WPT"; }
 
 private:
-    std::vector<double> forward1D(const std::vector<double>& data, int level);
-    std::vector<double> reverse1D(const std::vector<double>& data, int level);
-
     std::shared_ptr<Wavelet> wavelet_;
+
+    // Ping-pong buffers reused across calls
+    std::vector<double> scratch_;
+    std::vector<double> work_;
+};
+
+// Integer-to-integer LeGall 5/3 lifting transform. Works on int residuals
+// directly and is exactly reversible, so it gives a lossless path.
+class LiftingTransform {
+public:
+    // In-place transforms of `count` square blocks of side n, using the same
+    // structure-of-arrays layout as WaveletTransform::forwardBatch
+    void forward(int32_t* data, size_t n, size_t count = 1);
+    void reverse(int32_t* data, size_t n, size_t count = 1);
+
+private:
+    void transpose(int32_t* data, size_t n, size_t count);
+
+    std::vector<int32_t> scratch_;
 };
 
+// True when a channel is coded with LiftingTransform instead of a float transform
+inline bool usesLifting(const ChannelConfig& config) {
+    return config.waveletType == WaveletType::LEGALL53 ||
+           (config.waveletType != WaveletType::NONE && config.transformType == TransformType::LIFTING);
+}
+
 // Magnitude compressor
 class MagnitudeCompressor {
 public:
     explicit MagnitudeCompressor(double threshold);
 
-    std::vector<std::vector<double>> compress(const std::vector<std::vector<double>>& data);
+    // Zero coefficients below the threshold, in place over a flat buffer
+    void compress(double* data, size_t size) const;
 
 private:
     double threshold_;
@@ -0,0 +1,284 @@
+#include "check.hpp"
+#include "bitio.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace glic;
+
+namespace {
+
+// Deterministic pseudo-random source
+struct Lcg {
+    uint32_t state;
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+};
+
+uint32_t mask(int numBits) {
+    return numBits >= 32 ? ~0u : (1u << numBits) - 1;
+}
+
+// Reference MSB-first packer, one bit at a time
+struct ReferenceWriter {
+    std::vector<uint8_t> bytes;
+    size_t bits = 0;
+    void put(uint32_t value, int numBits) {
+        for (int i = numBits - 1; i >= 0; i--) {
+            if (bits % 8 == 0) bytes.push_back(0);
+            if ((value >> i) & 1) bytes.back() |= static_cast<uint8_t>(0x80 >> (bits % 8));
+            bits++;
+        }
+    }
+    void align() { bits = (bits + 7) / 8 * 8; }
+};
+
+// One write in a mixed sequence
+struct Op {
+    int kind;  // 0 bits, 1 bit, 2 signed int, 3 byte run, 4 unary, 5 field run
+    uint32_t value;
+    int numBits;
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> fields;
+};
+
+std::vector<Op> makeOps(uint32_t seed, size_t count) {
+    Lcg rng{seed};
+    std::vector<Op> ops;
+    for (size_t i = 0; i < count; i++) {
+        Op op;
+        op.kind = static_cast<int>(rng.next() % 8);
+        if (op.kind > 5) op.kind = 0;
+        op.numBits = static_cast<int>(rng.next() % 33);
+        op.value = rng.next() & mask(op.numBits);
+        if (op.kind == 1) {
+            op.numBits = 1;
+            op.value &= 1;
+        } else if (op.kind == 2 && op.numBits == 0) {
+            op.numBits = 1;
+            op.value &= 1;
+        } else if (op.kind == 3) {
+            op.bytes.resize(rng.next() % 12);
+            for (auto& b : op.bytes) b = static_cast<uint8_t>(rng.next());
+            op.numBits = 0;
+        } else if (op.kind == 4) {
+            // numBits is the limit, value the run of zeros (at most the limit)
+            op.numBits = 1 + static_cast<int>(rng.next() % 32);
+            op.value = rng.next() % (op.numBits + 1);
+        } else if (op.kind == 5) {
+            op.fields.resize(rng.next() % 40);
+            for (auto& f : op.fields) f = rng.next() & mask(op.numBits);
+        }
+        ops.push_back(op);
+    }
+    return ops;
+}
+
+// Writes and reads back a mixed sequence: field widths 0-32 at every bit
+// offset, so reads cross the 64-bit refill boundary in all positions, plus
+// byte runs that take the aligned copy path or the bitwise one
+void testMixedSequence(uint32_t seed) {
+    auto ops = makeOps(seed, 600);
+
+    BitWriter writer;
+    ReferenceWriter reference;
+    for (const auto& op : ops) {
+        switch (op.kind) {
+            case 0: writer.writeBits(op.value, op.numBits); break;
+            case 1: writer.writeBit(op.value != 0); break;
+            case 2: writer.writeInt(static_cast<int32_t>(op.value), true, op.numBits); break;
+            case 3: writer.writeBytes(op.bytes.data(), op.bytes.size()); break;
+            case 4:
+                writer.writeBits(0, static_cast<int>(op.value));
+                if (static_cast<int>(op.value) < op.numBits) writer.writeBit(true);
+                break;
+            case 5:
+                for (uint32_t f : op.fields) writer.writeBits(f, op.numBits);
+                break;
+        }
+        if (op.kind == 3) {
+            for (uint8_t b : op.bytes) reference.put(b, 8);
+        } else if (op.kind == 4) {
+            reference.put(0, static_cast<int>(op.value));
+            if (static_cast<int>(op.value) < op.numBits) reference.put(1, 1);
+        } else if (op.kind == 5) {
+            for (uint32_t f : op.fields) reference.put(f, op.numBits);
+        } else {
+            reference.put(op.value, op.numBits);
+        }
+    }
+    writer.align();
+    reference.align();
+    CHECK(writer.data() == reference.bytes);
+
+    const auto& data = writer.data();
+    BitReader reader(data.data(), data.size());
+    bool match = true;
+    for (const auto& op : ops) {
+        switch (op.kind) {
+            case 0:
+                match &= reader.readBits(op.numBits) == op.value;
+                break;
+            case 1:
+                match &= reader.readBit() == (op.value != 0);
+                break;
+            case 2: {
+                // Sign-extended back from the field width, including 32
+                int32_t expected = static_cast<int32_t>(op.value);
+                if (op.numBits < 32 && (op.value >> (op.numBits - 1)) & 1) {
+                    expected = static_cast<int32_t>(op.value | ~mask(op.numBits));
+                }
+                match &= reader.readInt(true, op.numBits) == expected;
+                break;
+            }
+            case 3: {
+                std::vector<uint8_t> bytes(op.bytes.size());
+                reader.readBytes(bytes.data(), bytes.size());
+                match &= bytes == op.bytes;
+                break;
+            }
+            case 4:
+                match &= reader.readUnary(op.numBits) == static_cast<int>(op.value);
+                break;
+            case 5: {
+                std::vector<uint32_t> fields(op.fields.size());
+                reader.readFields(fields.data(), fields.size(), op.numBits);
+                match &= fields == op.fields;
+                break;
+            }
+        }
+    }
+    CHECK(match);
+    CHECK(!reader.overrun());
+}
+
+// Streams of every short length take the byte-at-a-time refill tail; reading
+// one field past the end yields zero bits and sets the flag for good
+void testOverrun() {
+    for (size_t size = 0; size <= 20; size++) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++) data[i] = static_cast<uint8_t>(0xA5 ^ (i * 29));
+
+        BitReader reader(data.data(), data.size());
+        bool match = true;
+        // 13-bit fields drift across byte and word boundaries
+        size_t fields = size * 8 / 13;
+        for (size_t f = 0; f < fields; f++) {
+            uint32_t expected = 0;
+            for (int b = 0; b < 13; b++) {
+                size_t bit = f * 13 + b;
+                expected = (expected << 1) | ((data[bit / 8] >> (7 - bit % 8)) & 1);
+            }
+            match &= reader.readBits(13) == expected;
+        }
+        CHECK(match);
+        CHECK(!reader.overrun());
+
+        // The leftover bits come back with zero fill below them
+        size_t left = size * 8 - fields * 13;
+        uint32_t tail = 0;
+        for (size_t b = 0; b < left; b++) {
+            size_t bit = fields * 13 + b;
+            tail = (tail << 1) | ((data[bit / 8] >> (7 - bit % 8)) & 1);
+        }
+        CHECK(reader.readBits(13) == tail << (13 - left));
+        CHECK(reader.overrun());
+        CHECK(reader.readBits(32) == 0);
+        CHECK(reader.readBit() == false);
+        CHECK(reader.overrun());
+        CHECK(reader.eof());
+    }
+}
+
+// A unary run cut off by the end of the stream returns the limit and
+// sets the overrun flag; a run that ends exactly at the limit does not
+void testUnaryOverrun() {
+    const uint8_t zeros[3] = {0, 0, 0};
+    for (int limit = 1; limit <= 32; limit++) {
+        BitReader reader(zeros, sizeof(zeros));
+        CHECK(reader.readUnary(limit) == limit);
+        CHECK(reader.overrun() == (limit > 24));
+    }
+
+    const uint8_t oneAtEnd[5] = {0, 0, 0, 0, 1};
+    BitReader reader(oneAtEnd, sizeof(oneAtEnd));
+    CHECK(reader.readUnary(32) == 32);
+    CHECK(reader.readUnary(32) == 7);
+    CHECK(!reader.overrun());
+    CHECK(reader.readUnary(4) == 4);
+    CHECK(reader.overrun());
+}
+
+// readFields unpacks in bulk until eight bytes from the end, then falls
+// back to readBits; a run past the end reads zeros and sets the flag
+void testFieldsNearEnd() {
+    for (int width : {1, 7, 13, 32}) {
+        for (size_t size = 0; size <= 24; size++) {
+            std::vector<uint8_t> data(size);
+            for (size_t i = 0; i < size; i++) data[i] = static_cast<uint8_t>(0x3C + i * 71);
+
+            for (size_t skip : {size_t(0), size_t(3)}) {
+                size_t fit = size * 8 >= skip ? (size * 8 - skip) / width : 0;
+                std::vector<uint32_t> expected(fit + 2, 0);
+                BitReader bits(data.data(), data.size());
+                bits.readBits(static_cast<int>(skip));
+                for (size_t f = 0; f < fit; f++) expected[f] = bits.readBits(width);
+
+                BitReader reader(data.data(), data.size());
+                reader.readBits(static_cast<int>(skip));
+                std::vector<uint32_t> exact(fit);
+                reader.readFields(exact.data(), fit, width);
+                CHECK(std::equal(exact.begin(), exact.end(), expected.begin()));
+                CHECK(reader.overrun() == (size * 8 < skip));
+
+                // Two more fields cannot both fit
+                BitReader past(data.data(), data.size());
+                past.readBits(static_cast<int>(skip));
+                std::vector<uint32_t> over(fit + 2);
+                past.readFields(over.data(), over.size(), width);
+                CHECK(std::equal(over.begin(), over.begin() + fit, expected.begin()));
+                CHECK(over.back() == 0);
+                CHECK(past.overrun());
+            }
+        }
+    }
+}
+
+// A 32-bit field must not be sign-extended past itself
+void testWideFields() {
+    BitWriter writer;
+    writer.writeBit(true);
+    writer.writeInt(INT32_MIN, true, 32);
+    writer.writeInt(-1, true, 32);
+    writer.writeInt(0x7FFFFFFF, true, 32);
+    writer.writeBits(0xFFFFFFFFu, 32);
+    writer.writeInt(-4096, true, 13);
+    writer.writeInt(4095, true, 13);
+    writer.align();
+
+    const auto& data = writer.data();
+    BitReader reader(data.data(), data.size());
+    CHECK(reader.readBit());
+    CHECK(reader.readInt(true, 32) == INT32_MIN);
+    CHECK(reader.readInt(true, 32) == -1);
+    CHECK(reader.readInt(true, 32) == 0x7FFFFFFF);
+    CHECK(reader.readBits(32) == 0xFFFFFFFFu);
+    CHECK(reader.readInt(true, 13) == -4096);
+    CHECK(reader.readInt(true, 13) == 4095);
+    CHECK(!reader.overrun());
+}
+
+} // anonymous namespace
+
+int main() {
+    for (uint32_t seed = 1; seed <= 16; seed++) {
+        testMixedSequence(seed);
+    }
+    testOverrun();
+    testUnaryOverrun();
+    testFieldsNearEnd();
+    testWideFields();
+    return test::result();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Minimal checks for the test executables: a failed CHECK is reported and
+// counted, and main() returns glic::test::result()
+#define CHECK(cond)                                                                \
+    do {                                                                           \
+        if (!(cond)) {                                                             \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" \
+                      << std::endl;                                                \
+            glic::test::failures()++;                                              \
+        }                                                                          \
+    } while (0)
+
+namespace glic {
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int result() {
+    if (failures() > 0) {
+        std::cerr << failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Deterministic image with smooth areas and edges, so segmentation splits
+inline std::vector<Color> testImage(int width, int height) {
+    std::vector<Color> pixels(static_cast<size_t>(width) * height);
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            uint8_t noise = static_cast<uint8_t>(seed >> 28);
+            uint8_t r = static_cast<uint8_t>(x * 255 / width);
+            uint8_t g = static_cast<uint8_t>((x / 8 + y / 8) % 2 ? 200 : 40);
+            uint8_t b = static_cast<uint8_t>(y * 255 / height + noise);
+            pixels[static_cast<size_t>(y) * width + x] = makeColor(r, g, b);
+        }
+    }
+    return pixels;
+}
+
+} // namespace test
+} // namespace glic
@@ -0,0 +1,110 @@
+#include "check.hpp"
+#include "glic.hpp"
+
+using namespace glic;
+
+namespace {
+
+void putU32(std::vector<uint8_t>& buffer, size_t pos, uint32_t v) {
+    buffer[pos] = static_cast<uint8_t>(v >> 24);
+    buffer[pos + 1] = static_cast<uint8_t>(v >> 16);
+    buffer[pos + 2] = static_cast<uint8_t>(v >> 8);
+    buffer[pos + 3] = static_cast<uint8_t>(v);
+}
+
+// Width and height follow the magic and version
+constexpr size_t WIDTH_POS = 6;
+constexpr size_t HEIGHT_POS = 10;
+
+void testValidFile(const std::vector<uint8_t>& file) {
+    GlicInfo info = probe(file.data(), file.size(), true);
+    CHECK(info.success);
+    CHECK(info.container.width == 64);
+    CHECK(info.container.height == 48);
+
+    GlicCodec codec;
+    GlicResult result = codec.decodeFromBuffer(file);
+    CHECK(result.success);
+    CHECK(result.pixels.size() == 64u * 48u);
+}
+
+// A corrupted height is rejected from the header alone, before the
+// segmentation is walked or planes are allocated
+void testCorruptedHeight(std::vector<uint8_t> file) {
+    putU32(file, HEIGHT_POS, 1694498877u);
+
+    GlicInfo info = probe(file.data(), file.size(), true);
+    CHECK(!info.success);
+    CHECK(info.error == "Invalid image dimensions");
+
+    GlicCodec codec;
+    GlicResult result = codec.decodeFromBuffer(file);
+    CHECK(!result.success);
+    CHECK(result.error.find("Invalid image dimensions") != std::string::npos);
+}
+
+void testOutOfRangeDimensions(const std::vector<uint8_t>& file) {
+    const uint32_t cases[][2] = {
+        {0, 48},
+        {64, 0},
+        {GLIC_MAX_DIMENSION + 1, 1},
+        {0x80000000u, 48},
+        {GLIC_MAX_DIMENSION, GLIC_MAX_DIMENSION},
+    };
+    for (const auto& dims : cases) {
+        std::vector<uint8_t> bad = file;
+        putU32(bad, WIDTH_POS, dims[0]);
+        putU32(bad, HEIGHT_POS, dims[1]);
+        GlicInfo info = probe(bad.data(), bad.size(), false);
+        CHECK(!info.success);
+    }
+}
+
+void testTruncated(const std::vector<uint8_t>& file) {
+    // Header cut short
+    GlicInfo info = probe(file.data(), 100, true);
+    CHECK(!info.success);
+
+    GlicCodec codec;
+    GlicResult result = codec.decodeFromBuffer(file.data(), 100);
+    CHECK(!result.success);
+
+    // Header intact, sections missing
+    size_t headerOnly = sectionTableOffset() + 8;
+    info = probe(file.data(), headerOnly, true);
+    CHECK(!info.success);
+    result = codec.decodeFromBuffer(file.data(), headerOnly);
+    CHECK(!result.success);
+}
+
+// Images a decoder would reject are not written
+void testEncodeRejectsOversize() {
+    std::vector<Color> row(GLIC_MAX_DIMENSION + 1, makeColor(0, 0, 0));
+    GlicCodec codec;
+    CHECK(codec.encodeToBuffer(row.data(), GLIC_MAX_DIMENSION + 1, 1).empty());
+
+    // Refused before any output file is created
+    GlicResult result = codec.encode(row.data(), GLIC_MAX_DIMENSION + 1, 1, "missing-dir/out.glic");
+    CHECK(!result.success);
+    CHECK(result.error == "Invalid image dimensions");
+}
+
+} // anonymous namespace
+
+int main() {
+    auto pixels = test::testImage(64, 48);
+    GlicCodec codec;
+    std::vector<uint8_t> file = codec.encodeToBuffer(pixels.data(), 64, 48);
+    CHECK(!file.empty());
+    if (file.empty()) {
+        return test::result();
+    }
+
+    testValidFile(file);
+    testCorruptedHeight(file);
+    testOutOfRangeDimensions(file);
+    testTruncated(file);
+    testEncodeRejectsOversize();
+
+    return test::result();
+}
@@ -0,0 +1,379 @@
+#include "check.hpp"
+#include "encoding.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace glic;
+
+namespace {
+
+// Methods that code the stored PACKED fields and must decode them exactly
+const EncodingMethod METHODS[] = {
+    EncodingMethod::PACKED,
+    EncodingMethod::RANS,
+    EncodingMethod::RICE,
+    EncodingMethod::HUFFMAN,
+    EncodingMethod::BLOCKPACK,
+    EncodingMethod::SIGMAP,
+};
+
+constexpr int PLANE_SIZE = 32;
+
+// Deterministic pseudo-random source
+struct Lcg {
+    uint32_t state;
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+};
+
+// A stored field layout and the channel config that selects it
+struct Field {
+    std::string name;
+    int width;
+    bool isSigned;
+    ChannelConfig config;
+
+    int64_t lowest() const {
+        return isSigned ? -(int64_t(1) << (width - 1)) : 0;
+    }
+    int64_t highest() const {
+        int64_t top = isSigned ? (int64_t(1) << (width - 1)) - 1 : (int64_t(1) << width) - 1;
+        return std::min<int64_t>(top, std::numeric_limits<int32_t>::max());
+    }
+};
+
+// Transformed channels with a recorded coefficient width store signed fields
+Field signedField(int width) {
+    Field field{"signed " + std::to_string(width), width, true, ChannelConfig{}};
+    field.config.waveletType = WaveletType::HAAR;
+    field.config.coefficientBits = width;
+    return field;
+}
+
+// Otherwise fields are unsigned, one bit wider than the scale's magnitude bits
+Field unsignedField(int width, int transformScale) {
+    Field field{"unsigned " + std::to_string(width), width, false, ChannelConfig{}};
+    field.config.waveletType = WaveletType::HAAR;
+    field.config.transformScale = transformScale;
+    return field;
+}
+
+std::vector<Field> fields() {
+    std::vector<Field> result;
+    for (int width : {1, 12, 13, 32}) {
+        result.push_back(signedField(width));
+    }
+    result.push_back(unsignedField(1, 1));
+    result.push_back(unsignedField(12, 2048));
+    result.push_back(unsignedField(13, 4096));
+    result.push_back(unsignedField(32, 3 << 29));
+
+    // Untransformed channels: 9-bit unsigned, or 8-bit signed under MOD256
+    Field plain{"plain 9", 9, false, ChannelConfig{}};
+    plain.config.waveletType = WaveletType::NONE;
+    result.push_back(plain);
+    Field wrapped{"mod256 8", 8, true, ChannelConfig{}};
+    wrapped.config.waveletType = WaveletType::NONE;
+    wrapped.config.clampMethod = ClampMethod::MOD256;
+    result.push_back(wrapped);
+    return result;
+}
+
+// Mixed block sizes tiling the plane
+std::vector<Segment> segments() {
+    std::vector<Segment> result;
+    auto add = [&](int x, int y, int size) {
+        Segment seg;
+        seg.x = x;
+        seg.y = y;
+        seg.size = size;
+        result.push_back(seg);
+    };
+    add(0, 0, 16);
+    add(16, 0, 16);
+    for (int i = 0; i < 4; i++) {
+        add((i % 2) * 8, 16 + (i / 2) * 8, 8);
+    }
+    for (int i = 0; i < 16; i++) {
+        add(16 + (i % 4) * 4, 16 + (i / 4) * 4, 4);
+    }
+    return result;
+}
+
+// Mostly small values around zero, with some spread over the whole field
+// and both extremes present
+void fillPlane(Planes& planes, const Field& field, uint32_t seed) {
+    Lcg rng{seed};
+    int64_t lo = field.lowest();
+    int64_t hi = field.highest();
+    uint64_t span = static_cast<uint64_t>(hi - lo) + 1;
+    for (int x = 0; x < PLANE_SIZE; x++) {
+        for (int y = 0; y < PLANE_SIZE; y++) {
+            int64_t v;
+            if (rng.next() % 8 == 0) {
+                v = lo + static_cast<int64_t>((uint64_t(rng.next()) << 32 | rng.next()) % span);
+            } else {
+                v = static_cast<int64_t>(rng.next() % 9) - (field.isSigned ? 4 : 0);
+                v = std::max(lo, std::min(hi, v));
+            }
+            planes.set(0, x, y, static_cast<int>(v));
+        }
+    }
+    planes.set(0, 0, 0, static_cast<int>(lo));
+    planes.set(0, PLANE_SIZE - 1, PLANE_SIZE - 1, static_cast<int>(hi));
+}
+
+// Per-channel coder state the codec stores in the channel header
+ChannelConfig coderConfig(const Planes& planes, const std::vector<Segment>& segs,
+                          EncodingMethod method, ChannelConfig config) {
+    if (method == EncodingMethod::HUFFMAN) {
+        config.codeLengths = huffmanCodeLengths(planes, 0, segs, config);
+    }
+    return config;
+}
+
+std::vector<uint8_t> encode(const Planes& planes, const std::vector<Segment>& segs,
+                            EncodingMethod method, const ChannelConfig& config) {
+    BitWriter writer;
+    encodeData(writer, planes, 0, segs, method, config);
+    writer.align();
+    return writer.data();
+}
+
+// Decodes into a plane holding a sentinel, so unwritten samples show up
+bool decodesTo(const std::vector<uint8_t>& data, const Planes& expected, const std::vector<Segment>& segs,
+               EncodingMethod method, const ChannelConfig& config) {
+    Planes decoded(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+    for (const auto& seg : segs) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                decoded.set(0, seg.x + x, seg.y + y, 0x5A5A5A5);
+            }
+        }
+    }
+    BitReader reader(data.data(), data.size());
+    decodeData(reader, decoded, 0, segs, method, config);
+
+    for (const auto& seg : segs) {
+        for (int x = 0; x < seg.size; x++) {
+            for (int y = 0; y < seg.size; y++) {
+                if (decoded.get(0, seg.x + x, seg.y + y) != expected.get(0, seg.x + x, seg.y + y)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Every method round-trips every field layout, and costing with a
+// BitCounter gives exactly the written size
+void testRoundTrips() {
+    auto segs = segments();
+    for (const auto& field : fields()) {
+        Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+        fillPlane(planes, field, 7 + field.width);
+
+        for (EncodingMethod method : METHODS) {
+            ChannelConfig config = coderConfig(planes, segs, method, field.config);
+            auto data = encode(planes, segs, method, config);
+            bool ok = decodesTo(data, planes, segs, method, config);
+            if (!ok) {
+                std::cerr << encodingName(method) << " failed on " << field.name << std::endl;
+            }
+            CHECK(ok);
+
+            BitCounter counter;
+            encodeData(counter, planes, 0, segs, method, config);
+            counter.align();
+            CHECK(counter.bits() == data.size() * 8);
+        }
+
+        // PACKED writes exactly the field width, which pins the layout down
+        auto packed = encode(planes, segs, EncodingMethod::PACKED, field.config);
+        uint64_t samples = PLANE_SIZE * PLANE_SIZE;
+        CHECK(packed.size() == (samples * field.width + 7) / 8);
+    }
+}
+
+// Symbols from 4095 up are escaped to raw bits after the rANS payload;
+// values straddling that boundary and a plane made only of escapes
+void testRansEscapes() {
+    auto segs = segments();
+    Field field = signedField(13);
+    Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+
+    // Zigzag symbols 4093-4098 are values -2047, 2047, -2048, 2048, -2049, 2049
+    const int boundary[] = {-2047, 2047, -2048, 2048, -2049, 2049, 0, -4096, 4095};
+    for (int x = 0; x < PLANE_SIZE; x++) {
+        for (int y = 0; y < PLANE_SIZE; y++) {
+            planes.set(0, x, y, boundary[(x * PLANE_SIZE + y) % 9]);
+        }
+    }
+    auto data = encode(planes, segs, EncodingMethod::RANS, field.config);
+    CHECK(decodesTo(data, planes, segs, EncodingMethod::RANS, field.config));
+
+    Field wide = signedField(32);
+    Lcg rng{99};
+    for (int x = 0; x < PLANE_SIZE; x++) {
+        for (int y = 0; y < PLANE_SIZE; y++) {
+            int v = static_cast<int>(rng.next() | 0x10000u);
+            planes.set(0, x, y, v);
+        }
+    }
+    data = encode(planes, segs, EncodingMethod::RANS, wide.config);
+    CHECK(decodesTo(data, planes, segs, EncodingMethod::RANS, wide.config));
+}
+
+// A channel holding one value has a one-symbol Huffman alphabet
+void testSingleSymbolHuffman() {
+    auto segs = segments();
+    for (int value : {0, 5, 300, -1}) {
+        Field field = signedField(13);
+        Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+        for (int x = 0; x < PLANE_SIZE; x++) {
+            for (int y = 0; y < PLANE_SIZE; y++) {
+                planes.set(0, x, y, value);
+            }
+        }
+        ChannelConfig config = coderConfig(planes, segs, EncodingMethod::HUFFMAN, field.config);
+        auto data = encode(planes, segs, EncodingMethod::HUFFMAN, config);
+        CHECK(decodesTo(data, planes, segs, EncodingMethod::HUFFMAN, config));
+
+        BitCounter counter;
+        encodeData(counter, planes, 0, segs, EncodingMethod::HUFFMAN, config);
+        counter.align();
+        CHECK(counter.bits() == data.size() * 8);
+    }
+}
+
+// A segment spanning the whole signed 32-bit range has 32-bit offsets from
+// its minimum; the others stay narrow
+void testBlockPackWideOffsets() {
+    auto segs = segments();
+    Field field = signedField(32);
+    Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+    fillPlane(planes, field, 3);
+    planes.set(0, 1, 2, std::numeric_limits<int32_t>::min());
+    planes.set(0, 2, 1, std::numeric_limits<int32_t>::max());
+    for (int x = 16; x < PLANE_SIZE; x++) {
+        for (int y = 0; y < 16; y++) {
+            planes.set(0, x, y, 42);
+        }
+    }
+
+    auto data = encode(planes, segs, EncodingMethod::BLOCKPACK, field.config);
+    CHECK(decodesTo(data, planes, segs, EncodingMethod::BLOCKPACK, field.config));
+}
+
+// SIGMAP codes magnitudes as a bit-length class and mantissa; the widest
+// class is 32 bits, reached only by INT32_MIN
+void testSigMapWideMagnitudes() {
+    auto segs = segments();
+    Field field = signedField(32);
+    Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+    const int32_t wide[] = {
+        std::numeric_limits<int32_t>::min(),
+        std::numeric_limits<int32_t>::max(),
+        -std::numeric_limits<int32_t>::max(),
+        1 << 30,
+        -(1 << 30),
+        0,
+        1,
+    };
+    for (int x = 0; x < PLANE_SIZE; x++) {
+        for (int y = 0; y < PLANE_SIZE; y++) {
+            planes.set(0, x, y, wide[(x * 3 + y) % 7]);
+        }
+    }
+
+    auto data = encode(planes, segs, EncodingMethod::SIGMAP, field.config);
+    CHECK(decodesTo(data, planes, segs, EncodingMethod::SIGMAP, field.config));
+}
+
+// LAYERED keeps its layers apart for the container to interleave
+std::vector<LayerSpan> spans(const ChannelLayers& coded, size_t count) {
+    std::vector<LayerSpan> result;
+    for (size_t i = 0; i < count && i < coded.layers.size(); i++) {
+        result.push_back(LayerSpan{coded.layers[i].data(), coded.layers[i].size()});
+    }
+    return result;
+}
+
+// With every layer present LAYERED decodes every field layout exactly
+void testLayeredRoundTrips() {
+    auto segs = segments();
+    for (const auto& field : fields()) {
+        Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+        fillPlane(planes, field, 11 + field.width);
+
+        ChannelLayers coded = encodeLayers(planes, 0, segs, field.config);
+        CHECK(coded.layers.size() == static_cast<size_t>(std::min(coded.planes, MAX_LAYERS)));
+
+        Planes decoded(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+        decodeLayers(spans(coded, coded.layers.size()), coded.planes, decoded, 0, segs, field.config);
+        bool ok = true;
+        for (int x = 0; x < PLANE_SIZE; x++) {
+            for (int y = 0; y < PLANE_SIZE; y++) {
+                ok &= decoded.get(0, x, y) == planes.get(0, x, y);
+            }
+        }
+        if (!ok) {
+            std::cerr << "LAYERED failed on " << field.name << std::endl;
+        }
+        CHECK(ok);
+    }
+}
+
+// Decoding from the first k layers leaves the planes of the missing ones
+// unknown: every value lands within that many low bits of the original, and
+// the error shrinks as layers are added
+void testTruncatedLayers() {
+    auto segs = segments();
+    for (int width : {13, 32}) {
+        Field field = signedField(width);
+        Planes planes(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+        fillPlane(planes, field, 5);
+
+        ChannelLayers coded = encodeLayers(planes, 0, segs, field.config);
+        int layers = static_cast<int>(coded.layers.size());
+        CHECK(layers == MAX_LAYERS);
+
+        int64_t previous = std::numeric_limits<int64_t>::max();
+        for (int kept = 1; kept <= layers; kept++) {
+            Planes decoded(PLANE_SIZE, PLANE_SIZE, ColorSpace::RGB);
+            decodeLayers(spans(coded, kept), coded.planes, decoded, 0, segs, field.config);
+
+            int64_t worst = 0;
+            for (int x = 0; x < PLANE_SIZE; x++) {
+                for (int y = 0; y < PLANE_SIZE; y++) {
+                    int64_t error = int64_t(decoded.get(0, x, y)) - planes.get(0, x, y);
+                    worst = std::max(worst, error < 0 ? -error : error);
+                }
+            }
+            int unknownPlanes = layers - kept;
+            CHECK(worst < (int64_t(1) << unknownPlanes));
+            CHECK(worst <= previous);
+            previous = worst;
+        }
+        CHECK(previous == 0);
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testRoundTrips();
+    testRansEscapes();
+    testSingleSymbolHuffman();
+    testBlockPackWideOffsets();
+    testSigMapWideMagnitudes();
+    testLayeredRoundTrips();
+    testTruncatedLayers();
+    return test::result();
+}
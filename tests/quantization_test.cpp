@@ -0,0 +1,97 @@
+#include "check.hpp"
+#include "quantization.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace glic;
+
+namespace {
+
+// Quantizer documents exactness for |v| below this bound
+constexpr int EXACT_LIMIT = 1 << 20;
+
+// Past this, values are sampled with a stride to keep the test fast
+constexpr int DENSE_LIMIT = 1 << 16;
+constexpr int SPARSE_STEP = 61;
+
+// Reference: the float divide/multiply and std::round the quantizer replaces
+int floatQuantize(int v, float val) {
+    return static_cast<int>(std::round(static_cast<float>(v) / val));
+}
+
+int floatDequantize(int v, float val) {
+    return static_cast<int>(std::round(static_cast<float>(v) * val));
+}
+
+// Compare one quantization setting against the float formula. Returns the
+// number of mismatches so one setting cannot flood the output.
+int checkSetting(int setting) {
+    float val = quantValue(setting);
+    Quantizer quant(val);
+    int mismatches = 0;
+
+    auto compare = [&](int v) {
+        if (quant.quantize(v) != floatQuantize(v, val)) mismatches++;
+        // Reconstruction as the codec runs it: quantize, then dequantize
+        int q = floatQuantize(v, val);
+        if (quant.dequantize(quant.quantize(v)) != floatDequantize(q, val)) mismatches++;
+        // Dequantize on its own, while the product stays in the exact range
+        if (std::abs(v) * val < EXACT_LIMIT && quant.dequantize(v) != floatDequantize(v, val)) mismatches++;
+    };
+
+    for (int v = -DENSE_LIMIT; v <= DENSE_LIMIT; v++) {
+        compare(v);
+    }
+    for (int v = DENSE_LIMIT; v < EXACT_LIMIT; v += SPARSE_STEP) {
+        compare(v);
+        compare(-v);
+    }
+    compare(EXACT_LIMIT - 1);
+    compare(-(EXACT_LIMIT - 1));
+    return mismatches;
+}
+
+void testScalar() {
+    // Every setting the channel config can hold
+    for (int setting = 0; setting < 256; setting++) {
+        Quantizer quant(quantValue(setting));
+        CHECK(quant.active() == (quantValue(setting) > 1));
+        if (!quant.active()) continue;
+
+        int mismatches = checkSetting(setting);
+        if (mismatches != 0) {
+            std::cerr << "quantization setting " << setting << ": " << mismatches << " mismatches" << std::endl;
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+// The row forms run in fixed chunks with a scalar tail; every length up to
+// a few chunks must agree with the scalar calls
+void testRows() {
+    Quantizer quant(quantValue(37));
+    for (size_t count = 0; count <= 35; count++) {
+        std::vector<int32_t> row(count);
+        for (size_t i = 0; i < count; i++) {
+            row[i] = static_cast<int32_t>(i * 977) - 9000;
+        }
+
+        std::vector<int32_t> quantized = row;
+        quant.quantizeRow(quantized.data(), count);
+        std::vector<int32_t> restored = quantized;
+        quant.dequantizeRow(restored.data(), count);
+
+        for (size_t i = 0; i < count; i++) {
+            CHECK(quantized[i] == quant.quantize(row[i]));
+            CHECK(restored[i] == quant.dequantize(quantized[i]));
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testScalar();
+    testRows();
+    return test::result();
+}
@@ -0,0 +1,175 @@
+#include "check.hpp"
+#include "glic.hpp"
+#include "prediction.hpp"
+
+using namespace glic;
+
+namespace {
+
+constexpr int WIDTH = 120;
+constexpr int HEIGHT = 88;
+
+// Rewrite every channel's prediction section so that most segments use REF
+// with vectors pointing left, up, ahead into later segments and past the
+// image edge. The encoder's REF search is not used: the residuals stay the
+// ones coded for PAETH, which still gives a valid stream to decode.
+std::vector<uint8_t> withRefPredictions(const std::vector<uint8_t>& file) {
+    ContainerInfo info;
+    std::string error;
+    CHECK(readContainer(file.data(), file.size(), info, error));
+
+    int ww = 1;
+    while (ww < info.width) ww *= 2;
+    int hh = 1;
+    while (hh < info.height) hh *= 2;
+
+    std::vector<std::vector<uint8_t>> payloads;
+    for (const auto& section : info.sections) {
+        const uint8_t* data = file.data() + section.offset;
+        std::vector<uint8_t> payload(data, data + section.length);
+
+        if (section.kind == SectionKind::PREDICTION) {
+            const Section* segSection = info.find(SectionKind::SEGMENTATION, section.channel);
+            BitReader segReader(file.data() + segSection->offset, segSection->length);
+            auto segments = readSegmentation(segReader, ww, hh, info.width, info.height, true);
+
+            // Keep the skip flags, replace the predictors
+            BitReader predReader(payload.data(), payload.size());
+            BitWriter writer;
+            for (auto& seg : segments) {
+                seg.skip = predReader.readBoolean();
+                writer.writeBoolean(seg.skip);
+            }
+            writer.align();
+            for (size_t i = 0; i < segments.size(); i++) {
+                auto& seg = segments[i];
+                seg.predType = PredictionMethod::PAETH;
+                switch ((i + section.channel) % 4) {
+                    case 0:
+                        seg.predType = PredictionMethod::REF;
+                        seg.refX = static_cast<int16_t>(seg.x - seg.size - 3);
+                        seg.refY = static_cast<int16_t>(seg.y + 5);
+                        break;
+                    case 1:
+                        seg.predType = PredictionMethod::REF;
+                        seg.refX = static_cast<int16_t>(seg.x + 2 * seg.size + 1);
+                        seg.refY = static_cast<int16_t>(seg.y + seg.size / 2);
+                        break;
+                    case 2:
+                        seg.predType = PredictionMethod::REF;
+                        seg.refX = static_cast<int16_t>(WIDTH - 1 - seg.y);
+                        seg.refY = static_cast<int16_t>(seg.x - 7);
+                        break;
+                    default:
+                        break;
+                }
+            }
+            writePredictionData(writer, segments);
+            writer.align();
+            payload = writer.data();
+        }
+        payloads.push_back(std::move(payload));
+    }
+
+    // Lay the sections out again after the header and section table
+    info.flags &= static_cast<uint8_t>(~GLIC_FLAG_SIZE_TRAILER);
+    uint64_t offset = sectionTableOffset() + info.sections.size() * GLIC_SECTION_ENTRY_SIZE;
+    for (size_t i = 0; i < info.sections.size(); i++) {
+        info.sections[i].offset = offset;
+        info.sections[i].length = payloads[i].size();
+        offset += payloads[i].size();
+    }
+    std::vector<uint8_t> out = writeContainerHeader(info);
+    for (const auto& payload : payloads) {
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+    return out;
+}
+
+GlicResult decodeRegion(const std::vector<uint8_t>& file, int x, int y, int w, int h) {
+    GlicCodec codec;
+    DecodeOptions& options = codec.decodeOptions();
+    options.useRegion = true;
+    options.regionX = x;
+    options.regionY = y;
+    options.regionWidth = w;
+    options.regionHeight = h;
+    return codec.decodeFromBuffer(file);
+}
+
+// A region decode must equal the same rectangle of the full decode
+void testRegionsMatchFullDecode(const std::vector<uint8_t>& file) {
+    GlicCodec codec;
+    GlicResult full = codec.decodeFromBuffer(file);
+    CHECK(full.success);
+    if (!full.success) return;
+
+    const int regions[][4] = {
+        {0, 0, WIDTH, HEIGHT},
+        {0, 0, 1, 1},
+        {WIDTH - 1, HEIGHT - 1, 1, 1},
+        {37, 21, 19, 11},
+        {64, 0, WIDTH - 64, 16},
+        {0, 50, 30, HEIGHT - 50},
+        {90, 60, 13, 27},
+    };
+    for (const auto& r : regions) {
+        GlicResult part = decodeRegion(file, r[0], r[1], r[2], r[3]);
+        CHECK(part.success);
+        CHECK(part.width == r[2] && part.height == r[3]);
+        if (!part.success || part.pixels.size() != static_cast<size_t>(r[2]) * r[3]) continue;
+
+        int mismatches = 0;
+        for (int y = 0; y < r[3]; y++) {
+            for (int x = 0; x < r[2]; x++) {
+                Color expected = full.pixels[static_cast<size_t>(r[1] + y) * WIDTH + r[0] + x];
+                if (part.pixels[static_cast<size_t>(y) * r[2] + x] != expected) {
+                    mismatches++;
+                }
+            }
+        }
+        if (mismatches > 0) {
+            std::cerr << "region " << r[0] << "," << r[1] << "," << r[2] << "," << r[3] << ": "
+                      << mismatches << " pixels differ from the full decode" << std::endl;
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+// Empty regions and regions outside the image are errors, not full decodes
+void testInvalidRegions(const std::vector<uint8_t>& file) {
+    const int regions[][4] = {
+        {0, 0, 0, 0},
+        {10, 10, 0, 5},
+        {10, 10, 5, 0},
+        {10, 10, -4, 5},
+        {-1, 0, 5, 5},
+        {WIDTH - 4, 0, 5, 5},
+    };
+    for (const auto& r : regions) {
+        GlicResult part = decodeRegion(file, r[0], r[1], r[2], r[3]);
+        CHECK(!part.success);
+        CHECK(!part.error.empty());
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    auto pixels = test::testImage(WIDTH, HEIGHT);
+    GlicCodec codec;
+    std::vector<uint8_t> file = codec.encodeToBuffer(pixels.data(), WIDTH, HEIGHT);
+    CHECK(!file.empty());
+    if (file.empty()) {
+        return test::result();
+    }
+
+    // The stored predictors alone (PAETH) and with REF footprints
+    testRegionsMatchFullDecode(file);
+    std::vector<uint8_t> refFile = withRefPredictions(file);
+    CHECK(codec.decodeFromBuffer(refFile).pixels != codec.decodeFromBuffer(file).pixels);
+    testRegionsMatchFullDecode(refFile);
+    testInvalidRegions(refFile);
+
+    return test::result();
+}